@@ -24,6 +24,9 @@ extern "C" {
 // Includes
 // -----------------------------------------------------------------------------
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "LLKERNEL_flash_configuration.h"
 
 // -----------------------------------------------------------------------------
@@ -38,6 +41,25 @@ extern "C" {
 #define LLKERNEL_LOG_ASSERT     4
 #define LLKERNEL_LOG_NONE       5
 
+/**@brief Identifiers of the trace events, see LLKERNEL_flash_trace_event_t */
+#define LLKERNEL_FLASH_TRACE_MOUNT         1u // KF area mounted. size: number of features installed.
+#define LLKERNEL_FLASH_TRACE_ALLOCATE      2u // Feature allocated. address: handle, 0 on failure. size: ROM size.
+#define LLKERNEL_FLASH_TRACE_FREE          3u // Feature freed. address: handle.
+#define LLKERNEL_FLASH_TRACE_COPY          4u // LLKERNEL_IMPL_copyToROM() call. address: destination. size: bytes.
+#define LLKERNEL_FLASH_TRACE_FLUSH         5u // LLKERNEL_IMPL_flushCopyToROM() call. address: buffered page, 0 if
+                                              // none. size: buffered bytes.
+#define LLKERNEL_FLASH_TRACE_PROGRAM       6u // Program started. address: first byte. size: bytes.
+#define LLKERNEL_FLASH_TRACE_PAGE_READ     7u // Page read to be completed. address: page. size: page size.
+#define LLKERNEL_FLASH_TRACE_ERASE         8u // Erase started. address: erase unit. size: erase unit size.
+#define LLKERNEL_FLASH_TRACE_MMAP_ENABLE   9u // Memory mapped mode enabled.
+#define LLKERNEL_FLASH_TRACE_MMAP_DISABLE 10u // Memory mapped mode disabled.
+#define LLKERNEL_FLASH_TRACE_ERROR        11u // Copy or flush failed. address: destination, 0 for a flush. size: bytes.
+
+/**@brief Verification modes of the pages programmed by LLKERNEL_IMPL_copyToROM() */
+#define LLKERNEL_FLASH_VERIFY_PAGE      0 // Each page is read back after its program.
+#define LLKERNEL_FLASH_VERIFY_DEFERRED  1 // The pages programmed by a call are read back once at the end of the call.
+#define LLKERNEL_FLASH_VERIFY_CRC       2 // The CRC of the whole ROM area is checked once the feature is copied.
+
 #ifndef LLKERNEL_LOG_LEVEL
 	#error "LLKERNEL_LOG_LEVEL must be defined"
 #endif
@@ -78,6 +100,229 @@ extern "C" {
 	#define LLKERNEL_ASSERT_LOG(...)  ((void)0)
 #endif
 
+// -----------------------------------------------------------------------------
+// Typedef and Structure
+// -----------------------------------------------------------------------------
+
+/**@brief Information on a range of subsectors of the KF area */
+typedef struct {
+	uint32_t address; // Start address of the extent.
+	uint32_t nb_subsectors; // Number of subsectors of the extent.
+	uint32_t erase_count; // Highest erase count known for the subsectors of the extent.
+	bool used; // true if the extent is allocated to a feature, false if it is free.
+} LLKERNEL_flash_extent_info_t;
+
+/**@brief Statistics of a class of flash operations, times in LLKERNEL_FLASH_STATS_GET_TIME() units */
+typedef struct {
+	uint32_t count; // Number of operations.
+	uint32_t total_time; // Cumulative time of the operations.
+	uint32_t max_time; // Maximum time of an operation.
+} LLKERNEL_flash_op_stats_t;
+
+/**@brief Statistics of the flash operations, see LLKERNEL_flash_get_stats() */
+typedef struct {
+	LLKERNEL_flash_op_stats_t erase; // Subsector and block erases.
+	LLKERNEL_flash_op_stats_t program; // Page or range programs, only the start of an asynchronous program is timed.
+	LLKERNEL_flash_op_stats_t mmap_enable; // Calls enabling the memory mapped mode.
+	LLKERNEL_flash_op_stats_t mmap_disable; // Calls disabling the memory mapped mode.
+	uint32_t nb_pages_programmed; // Number of pages programmed.
+	uint32_t nb_bytes_written; // Number of bytes programmed.
+	uint32_t nb_page_reads; // Number of pages read by LLKERNEL_IMPL_copyToROM() to be completed and programmed.
+	uint32_t nb_verify_failures; // Number of flash content checks which failed.
+	uint32_t nb_pages_skipped; // Number of pages not programmed by a delta update because they are unchanged.
+} LLKERNEL_flash_stats_t;
+
+/**@brief Event of the flash operations trace, see LLKERNEL_flash_trace_read() */
+typedef struct {
+	uint32_t timestamp; // Value of LLKERNEL_FLASH_STATS_GET_TIME() when the event is recorded.
+	uint32_t address; // Address argument of the event.
+	uint32_t size; // Size argument of the event.
+	uint16_t id; // Identifier of the event, one of the LLKERNEL_FLASH_TRACE_* values.
+	uint16_t sequence; // Sequence number of the event, a gap means that events have been overwritten.
+} LLKERNEL_flash_trace_event_t;
+
+// -----------------------------------------------------------------------------
+// Public functions
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Gets the number of extents of the KF area. The KF area is covered by the extents in address order, either
+ * allocated to a feature or free.
+ *
+ * @retval The number of extents.
+ */
+int32_t LLKERNEL_flash_get_nb_extents(void);
+
+/**
+ * @brief Gets the information of an extent of the KF area. The erase count of an extent is the number of erases of
+ * its most erased subsector since the subsector was first allocated to a feature. It is stored in the header of the
+ * features, so the erase count of a free subsector which is not in the ROM area of a removed feature is lost at
+ * restart. Used to monitor the wear of the flash.
+ *
+ * @param[in] extent_index The index of the extent, from 0 to `LLKERNEL_flash_get_nb_extents()` - 1.
+ * @param[out] info The information of the extent.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR if the index is out of range.
+ */
+int32_t LLKERNEL_flash_get_extent_info(int32_t extent_index, LLKERNEL_flash_extent_info_t *info);
+
+#if (1 == LLKERNEL_FLASH_STATS)
+/**
+ * @brief Gets the statistics of the flash operations done since the startup or the last call to
+ * `LLKERNEL_flash_reset_stats()`.
+ *
+ * @param[out] stats The statistics.
+ */
+void LLKERNEL_flash_get_stats(LLKERNEL_flash_stats_t *stats);
+
+/**
+ * @brief Resets the statistics of the flash operations.
+ */
+void LLKERNEL_flash_reset_stats(void);
+#endif // LLKERNEL_FLASH_STATS
+
+#if (1 == LLKERNEL_FLASH_TRACE)
+/**
+ * @brief Reads the oldest events of the flash operations trace and removes them from the trace ring. The events can be
+ * dumped as is, for example to a file or a serial link, and decoded on the host with
+ * `src/main/python/llkernel_trace_decode.py`. Must not be called concurrently with the other LLKERNEL functions.
+ *
+ * @param[out] events The array filled with the events, oldest first.
+ * @param[in] max_events The size of the array.
+ *
+ * @retval The number of events read.
+ */
+uint32_t LLKERNEL_flash_trace_read(LLKERNEL_flash_trace_event_t *events, uint32_t max_events);
+#endif // LLKERNEL_FLASH_TRACE
+
+#if (1 == LLKERNEL_FLASH_SCRUB)
+/**
+ * @brief Erases in advance one subsector of the free KF area, so that the next feature allocations do not wait for its
+ * erase. A subsector already blank is only read. Intended to be called by the idle task of the BSP until it returns
+ * 0. The memory mapped mode is disabled only during the erase of one subsector.
+ *
+ * @retval 1 if a subsector has been scrubbed, 0 if all the free subsectors are scrubbed or if a feature installation
+ * is in progress, LLKERNEL_ERROR if the flash memory device returned an error.
+ *
+ * @warning This function must not be called concurrently with the LLKERNEL_IMPL functions.
+ */
+int32_t LLKERNEL_flash_scrub_step(void);
+#endif // LLKERNEL_FLASH_SCRUB
+
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+/**
+ * @brief Starts the in-place update of an installed feature with a new build. The new content is then copied with
+ * `LLKERNEL_IMPL_copyToROM()` into the current ROM area of the feature, followed by `LLKERNEL_IMPL_flushCopyToROM()`.
+ * Each page is compared with the flash content and is not programmed when it is unchanged, a subsector is erased only
+ * when one of its pages differs. The update ends with the next allocation, update or removal of a feature.
+ *
+ * @param[in] handle The handle of the installed feature.
+ * @param[in] size_ROM The size of the ROM section of the new build, it must fit in the subsectors of the feature.
+ * @param[in] size_RAM The size of the RAM section of the new build, it must not exceed the RAM area of the feature
+ * which is kept.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR if the feature is not installed, if the new build does not fit in the
+ * areas of the feature (the feature must then be uninstalled and installed again), or if the flash memory device
+ * returned an error.
+ *
+ * @warning An update interrupted by a reset leaves the feature with a mixed content. It is detected as corrupted and
+ * uninstalled when the Kernel loads it.
+ */
+int32_t LLKERNEL_flash_update_feature(int32_t handle, int32_t size_ROM, int32_t size_RAM);
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+
+#if (1 == LLKERNEL_FLASH_STAGED_UPDATE)
+/**
+ * @brief Starts the staged update of an installed feature with a new build. The new version is allocated in a free
+ * area of the KF area and copied with `LLKERNEL_IMPL_copyToROM()` at the returned address, while the installed version
+ * stays used. The update is then committed with `LLKERNEL_flash_commit_staged_feature()`. A single update is staged at a
+ * time, an update already staged is aborted.
+ *
+ * @param[in] handle The handle of the installed feature.
+ * @param[in] size_ROM The size of the ROM section of the new build.
+ * @param[in] size_RAM The size of the RAM section of the new build, it must not exceed the RAM area of the feature
+ * which is shared by both versions.
+ *
+ * @retval The address of the ROM area of the new version, NULL if the feature is not installed, if the new build does
+ * not fit, or if the flash memory device returned an error.
+ */
+void *LLKERNEL_flash_stage_feature(int32_t handle, int32_t size_ROM, int32_t size_RAM);
+
+/**
+ * @brief Commits the staged update: once the data copied are flushed and checked, the new version replaces the
+ * installed one at the same allocation index and the installed one is removed. When LLKERNEL_FLASH_VERIFY_MODE is
+ * LLKERNEL_FLASH_VERIFY_CRC, the whole ROM area must have been copied and match its CRC. The switch-over is a
+ * single program of the status of the new version header, an update interrupted by a reset is either not committed
+ * (the installed version is kept) or completed at the next mount. The update is rolled back when the content check
+ * fails.
+ *
+ * The feature must not be running: it gets a new handle and its RAM area is reused by the new version.
+ *
+ * @retval The handle of the new version, 0 if no update is staged, if the installed feature has been removed in the
+ * meantime, or if the new version content is invalid (the installed version is then kept).
+ */
+int32_t LLKERNEL_flash_commit_staged_feature(void);
+
+/**
+ * @brief Aborts the staged update, if any. The new version is removed and the installed one is kept.
+ */
+void LLKERNEL_flash_abort_staged_feature(void);
+#endif // LLKERNEL_FLASH_STAGED_UPDATE
+
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+/**
+ * @brief Gets the installation progress of a feature allocated by `LLKERNEL_IMPL_allocateFeature()`: the amount of
+ * bytes at the start of its ROM area that are durably programmed. The progress is recorded while the ROM area is copied
+ * with `LLKERNEL_IMPL_copyToROM()` in increasing address order, and survives a reset.
+ *
+ * @param[in] handle The handle of the feature.
+ *
+ * @retval The amount of bytes durably programmed, the size of the ROM area once the installation is complete,
+ * LLKERNEL_ERROR if the feature is not installed or if its progress is not recorded.
+ */
+int32_t LLKERNEL_flash_get_install_progress(int32_t handle);
+
+/**
+ * @brief Resumes the installation of a feature interrupted by a reset or by the loss of the download link. The part of
+ * the feature area following the recorded progress is erased, the ROM area must then be copied again with
+ * `LLKERNEL_IMPL_copyToROM()` from the returned offset, followed by `LLKERNEL_IMPL_flushCopyToROM()`.
+ *
+ * @param[in] handle The handle of the feature.
+ *
+ * @retval The offset in the ROM area from which the copy resumes, the size of the ROM area if the installation is
+ * complete, LLKERNEL_ERROR if the feature is not installed, if its progress is not recorded or if the flash memory
+ * device returned an error.
+ *
+ * @warning After a reset, the installation must be resumed before the Kernel loads the feature: the Kernel detects the
+ * incomplete feature as corrupted and uninstalls it.
+ */
+int32_t LLKERNEL_flash_resume_install(int32_t handle);
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+
+#if (1 == LLKERNEL_FLASH_INFLATE)
+/**
+ * @brief Starts the decompression of a compressed stream into the ROM area of a feature allocated by
+ * `LLKERNEL_IMPL_allocateFeature()`. The compressed stream is then given with `LLKERNEL_flash_inflate_copy()`, and the
+ * copy is ended with `LLKERNEL_IMPL_flushCopyToROM()`.
+ *
+ * @param[in] dest_address_ROM The address of the first decompressed byte in the ROM area of the feature.
+ */
+void LLKERNEL_flash_inflate_start(void *dest_address_ROM);
+
+/**
+ * @brief Decompresses a chunk of the compressed stream started by `LLKERNEL_flash_inflate_start()` and copies the
+ * decompressed bytes with `LLKERNEL_IMPL_copyToROM()`. The chunks can be of any size, a back-reference can be split
+ * over two chunks. The stream must be compressed with the heatshrink LZSS format, with the window and lookahead sizes
+ * LLKERNEL_FLASH_INFLATE_WINDOW_BITS and LLKERNEL_FLASH_INFLATE_LOOKAHEAD_BITS.
+ *
+ * @param[in] src_address The compressed chunk.
+ * @param[in] size The size of the compressed chunk in bytes.
+ *
+ * @retval The number of decompressed bytes copied, LLKERNEL_ERROR if no stream is started or if a copy failed.
+ */
+int32_t LLKERNEL_flash_inflate_copy(const void *src_address, int32_t size);
+#endif // LLKERNEL_FLASH_INFLATE
+
 // -----------------------------------------------------------------------------
 // EOF
 // -----------------------------------------------------------------------------
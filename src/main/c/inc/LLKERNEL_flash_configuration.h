@@ -53,10 +53,37 @@ extern "C" {
 #endif //LLKERNEL_RAM_ALIGN_SIZE
 
 /**
- * @brief LLKERNEL log level
+ * @brief Set to 1 to record the flash operations as compact binary events in a RAM ring, read with
+ * `LLKERNEL_flash_trace_read()` and decoded on the host with `src/main/python/llkernel_trace_decode.py`. An event is
+ * recorded in a few stores, so the trace can be left enabled in production, unlike the logs formatted by
+ * `LLKERNEL_TRACE`. The events are timestamped with LLKERNEL_FLASH_STATS_GET_TIME(). Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_TRACE)
+#define LLKERNEL_FLASH_TRACE  0
+#endif // LLKERNEL_FLASH_TRACE
+
+/**
+ * @brief Number of events kept in the trace ring when LLKERNEL_FLASH_TRACE is 1, an event takes 16 bytes. Once the
+ * ring is full, the oldest events are overwritten. Default is 128.
+ */
+#if !defined(LLKERNEL_FLASH_TRACE_SIZE)
+#define LLKERNEL_FLASH_TRACE_SIZE  128u
+#endif // LLKERNEL_FLASH_TRACE_SIZE
+
+#if (1u > LLKERNEL_FLASH_TRACE_SIZE)
+	#error "LLKERNEL_FLASH_TRACE_SIZE must be greater than 0"
+#endif
+
+/**
+ * @brief LLKERNEL log level. Default is LLKERNEL_LOG_DEBUG, LLKERNEL_LOG_WARNING when LLKERNEL_FLASH_TRACE is 1 so that
+ * the debug logs of the flash operations do not slow down the installations.
  */
 #if !defined(LLKERNEL_LOG_LEVEL)
+#if (1 == LLKERNEL_FLASH_TRACE)
+#define LLKERNEL_LOG_LEVEL LLKERNEL_LOG_WARNING
+#else
 #define LLKERNEL_LOG_LEVEL LLKERNEL_LOG_DEBUG
+#endif // LLKERNEL_FLASH_TRACE
 #endif // LLKERNEL_LOG_LEVEL
 
 /**
@@ -88,6 +115,22 @@ extern "C" {
 #define LLKERNEL_FLASH_PAGE_SIZE    (0x100u) // 256 bytes
 #endif // LLKERNEL_FLASH_PAGE_SIZE
 
+/**
+ * @brief Smallest amount of bytes the flash can program, a power of 2 dividing the page size. When it is smaller than
+ * the page size, only the bytes of a page updated by the LLKERNEL implementation are programmed, rounded to this unit:
+ * `flash_ctrl_page_write()` is then also called with an address inside a page. Default is LLKERNEL_FLASH_PAGE_SIZE,
+ * the pages are programmed whole.
+ */
+#if !defined(LLKERNEL_FLASH_PROGRAM_UNIT_SIZE)
+#define LLKERNEL_FLASH_PROGRAM_UNIT_SIZE  LLKERNEL_FLASH_PAGE_SIZE
+#endif // LLKERNEL_FLASH_PROGRAM_UNIT_SIZE
+
+#if (0u == LLKERNEL_FLASH_PROGRAM_UNIT_SIZE) || \
+	(0u != (LLKERNEL_FLASH_PROGRAM_UNIT_SIZE & (LLKERNEL_FLASH_PROGRAM_UNIT_SIZE - 1u))) || \
+	(LLKERNEL_FLASH_PAGE_SIZE < LLKERNEL_FLASH_PROGRAM_UNIT_SIZE)
+	#error "LLKERNEL_FLASH_PROGRAM_UNIT_SIZE must be a power of 2 not greater than LLKERNEL_FLASH_PAGE_SIZE"
+#endif
+
 /**
  * @brief Typical Flash subsector size. Default is 4 KB.
  */
@@ -116,6 +159,357 @@ extern "C" {
 #define LLKERNEL_KF_END             (LLKERNEL_KF_START + LLKERNEL_KF_BLOCK_SIZE)
 #endif // LLKERNEL_KF_END
 
+/**
+ * @brief Maximum number of features tracked by the KF area allocator. It must be greater than or equal to the
+ * `_java_max_nb_dynamic_features` link-time option. Default is 32.
+ */
+#if !defined(LLKERNEL_MAX_NB_FEATURES)
+#define LLKERNEL_MAX_NB_FEATURES    32u
+#endif // LLKERNEL_MAX_NB_FEATURES
+
+/**
+ * @brief Number of flash memory devices holding a KF area. When greater than 1, the devices are described by
+ * `flash_ctrl_get_devices()` and LLKERNEL_FLASH_PAGE_SIZE and LLKERNEL_FLASH_SUBSECTOR_SIZE must be the largest page
+ * and subsector sizes of the devices. Default is 1.
+ */
+#if !defined(LLKERNEL_FLASH_NB_DEVICES)
+#define LLKERNEL_FLASH_NB_DEVICES   1u
+#endif // LLKERNEL_FLASH_NB_DEVICES
+
+#if (1u > LLKERNEL_FLASH_NB_DEVICES)
+	#error "LLKERNEL_FLASH_NB_DEVICES must be greater than 0"
+#endif
+
+/**
+ * @brief Set to 1 to use LLKERNEL_FLASH_PAGE_SIZE and LLKERNEL_FLASH_SUBSECTOR_SIZE as the flash geometry instead of
+ * calling `flash_ctrl_get_page_size()`, `flash_ctrl_get_subsector_size()`, `flash_ctrl_get_page_address()` and
+ * `flash_ctrl_get_subsector_address()`. The page and subsector computations are then done with compile-time masks, both
+ * sizes must be powers of 2. When the geometry reported by the flash controller differs, no feature is mounted and the
+ * allocations fail. Set to 0 when the geometry is only known at runtime. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_STATIC_GEOMETRY)
+#define LLKERNEL_FLASH_STATIC_GEOMETRY  0
+#endif // LLKERNEL_FLASH_STATIC_GEOMETRY
+
+#if (1 == LLKERNEL_FLASH_STATIC_GEOMETRY)
+#if (0u != (LLKERNEL_FLASH_PAGE_SIZE & (LLKERNEL_FLASH_PAGE_SIZE - 1u))) || \
+	(0u != (LLKERNEL_FLASH_SUBSECTOR_SIZE & (LLKERNEL_FLASH_SUBSECTOR_SIZE - 1u)))
+	#error "LLKERNEL_FLASH_PAGE_SIZE and LLKERNEL_FLASH_SUBSECTOR_SIZE must be powers of 2"
+#endif
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+	#error "LLKERNEL_FLASH_STATIC_GEOMETRY is not supported with several flash devices"
+#endif
+#endif // LLKERNEL_FLASH_STATIC_GEOMETRY
+
+/**
+ * @brief Set to 1 to allocate a feature in the least erased free area large enough, instead of the first one. The
+ * erase counts are kept in the feature headers, see `LLKERNEL_flash_get_extent_info()`. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_WEAR_LEVELING)
+#define LLKERNEL_FLASH_WEAR_LEVELING  0
+#endif // LLKERNEL_FLASH_WEAR_LEVELING
+
+/**
+ * @brief Set to 1 to read a subsector before erasing it, and skip the erase when it is already blank (all bytes
+ * read as 0xFF). Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_BLANK_CHECK)
+#define LLKERNEL_FLASH_BLANK_CHECK  0
+#endif // LLKERNEL_FLASH_BLANK_CHECK
+
+/**
+ * @brief Set to 1 to enable `LLKERNEL_flash_scrub_step()`, which erases the free subsectors of the KF area in advance.
+ * The scrubbed subsectors are tracked in RAM with one bit per subsector of LLKERNEL_KF_BLOCK_SIZE. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_SCRUB)
+#define LLKERNEL_FLASH_SCRUB  0
+#endif // LLKERNEL_FLASH_SCRUB
+
+#if (1 == LLKERNEL_FLASH_SCRUB) && (1u < LLKERNEL_FLASH_NB_DEVICES)
+	#error "LLKERNEL_FLASH_SCRUB is not supported with several flash devices"
+#endif
+
+/**
+ * @brief Set to 1 when the flash controller implements `flash_ctrl_blank_check()`. The blank-check is done by
+ * reading the subsector in memory mapped mode otherwise. Only used when LLKERNEL_FLASH_BLANK_CHECK or
+ * LLKERNEL_FLASH_SCRUB is 1.
+ * Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_CTRL_BLANK_CHECK)
+#define LLKERNEL_FLASH_CTRL_BLANK_CHECK  0
+#endif // LLKERNEL_FLASH_CTRL_BLANK_CHECK
+
+/**
+ * @brief Set to 1 when the flash controller implements `flash_ctrl_get_block_size()` and `flash_ctrl_erase_block()`.
+ * The erase of large areas is then done by blocks, and by subsectors at the edges. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_CTRL_BLOCK_ERASE)
+#define LLKERNEL_FLASH_CTRL_BLOCK_ERASE  0
+#endif // LLKERNEL_FLASH_CTRL_BLOCK_ERASE
+
+/**
+ * @brief Set to 1 when the flash controller implements `flash_ctrl_page_write_async()` and
+ * `flash_ctrl_get_operation_status()`. The last page programmed by `LLKERNEL_IMPL_copyToROM()` is then completed
+ * during the next LLKERNEL call, so that the caller can get the next data while the page is programmed.
+ * Default is 0.
+ *
+ * @warning The memory mapped mode stays disabled between two LLKERNEL calls while a page program is pending. Enable
+ * this option only if no code or data is read from the flash memory by other tasks during a feature installation.
+ */
+#if !defined(LLKERNEL_FLASH_CTRL_ASYNC)
+#define LLKERNEL_FLASH_CTRL_ASYNC  0
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+
+/**
+ * @brief Set to 1 when the flash controller implements `flash_ctrl_write_range()`. The writes spanning several pages
+ * are then done with one call instead of one `flash_ctrl_page_write()` call per page. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_CTRL_WRITE_RANGE)
+#define LLKERNEL_FLASH_CTRL_WRITE_RANGE  0
+#endif // LLKERNEL_FLASH_CTRL_WRITE_RANGE
+
+/**
+ * @brief Set to 1 to program the whole pages copied by `LLKERNEL_IMPL_copyToROM()` directly from the source data,
+ * without copying them into the write buffer first. Only the partial pages at the start and at the end of a copy are
+ * staged in the write buffer. `flash_ctrl_page_write()` must then accept a source buffer at any address. Not supported
+ * with `LLKERNEL_FLASH_CTRL_ASYNC`, whose programs must not depend on the source data once
+ * `LLKERNEL_IMPL_copyToROM()` returns. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_ZERO_COPY)
+#define LLKERNEL_FLASH_ZERO_COPY  0
+#endif // LLKERNEL_FLASH_ZERO_COPY
+
+#if (1 == LLKERNEL_FLASH_ZERO_COPY) && (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+	#error "LLKERNEL_FLASH_ZERO_COPY is not supported with LLKERNEL_FLASH_CTRL_ASYNC"
+#endif
+
+/**
+ * @brief Set to 1 to bound the time during which the memory mapped mode is disabled by the erase of a large area. The
+ * memory mapped mode is enabled and LLKERNEL_FLASH_ERASE_YIELD_HOOK() is called each time
+ * LLKERNEL_FLASH_ERASE_BUDGET_SIZE bytes have been erased, so that the other tasks can execute from the flash.
+ * Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_ERASE_YIELD)
+#define LLKERNEL_FLASH_ERASE_YIELD  0
+#endif // LLKERNEL_FLASH_ERASE_YIELD
+
+/**
+ * @brief Function called between two erase steps when LLKERNEL_FLASH_ERASE_YIELD is 1, with the memory mapped mode
+ * enabled: `taskYIELD()` with FreeRTOS for example, or the exit and re-entry of a critical section. Default does
+ * nothing.
+ */
+#if !defined(LLKERNEL_FLASH_ERASE_YIELD_HOOK)
+#define LLKERNEL_FLASH_ERASE_YIELD_HOOK()  ((void)0)
+#endif // LLKERNEL_FLASH_ERASE_YIELD_HOOK
+
+/**
+ * @brief Amount of bytes erased between two calls of LLKERNEL_FLASH_ERASE_YIELD_HOOK() when LLKERNEL_FLASH_ERASE_YIELD
+ * is 1, a multiple of the subsector size. The blocks larger than this budget are erased by subsectors, unless the
+ * erase can be suspended. Default is LLKERNEL_FLASH_SUBSECTOR_SIZE.
+ */
+#if !defined(LLKERNEL_FLASH_ERASE_BUDGET_SIZE)
+#define LLKERNEL_FLASH_ERASE_BUDGET_SIZE  LLKERNEL_FLASH_SUBSECTOR_SIZE
+#endif // LLKERNEL_FLASH_ERASE_BUDGET_SIZE
+
+/**
+ * @brief Set to 1 when the flash controller implements `flash_ctrl_erase_async()`, `flash_ctrl_erase_suspend()`,
+ * `flash_ctrl_erase_resume()` and `flash_ctrl_get_operation_status()`. When LLKERNEL_FLASH_ERASE_YIELD is 1, an erase
+ * lasting more than LLKERNEL_FLASH_ERASE_BUDGET_TIME is then suspended to call LLKERNEL_FLASH_ERASE_YIELD_HOOK(), and
+ * the blocks are erased whatever LLKERNEL_FLASH_ERASE_BUDGET_SIZE. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_CTRL_ERASE_SUSPEND)
+#define LLKERNEL_FLASH_CTRL_ERASE_SUSPEND  0
+#endif // LLKERNEL_FLASH_CTRL_ERASE_SUSPEND
+
+/**
+ * @brief Duration of an erase before it is suspended when LLKERNEL_FLASH_CTRL_ERASE_SUSPEND is 1, measured with the
+ * time source LLKERNEL_FLASH_STATS_GET_TIME(), which must then be defined. It must be set when
+ * LLKERNEL_FLASH_ERASE_YIELD is also 1. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_ERASE_BUDGET_TIME)
+#define LLKERNEL_FLASH_ERASE_BUDGET_TIME  0u
+#endif // LLKERNEL_FLASH_ERASE_BUDGET_TIME
+
+#if (1 == LLKERNEL_FLASH_ERASE_YIELD) && (1 == LLKERNEL_FLASH_CTRL_ERASE_SUSPEND) \
+    && (0u == LLKERNEL_FLASH_ERASE_BUDGET_TIME)
+	#error "LLKERNEL_FLASH_ERASE_BUDGET_TIME must be greater than 0 when the erases can be suspended"
+#endif
+
+/**
+ * @brief Number of page buffers used by `LLKERNEL_IMPL_copyToROM()` when LLKERNEL_FLASH_CTRL_ASYNC is 1. A buffer is
+ * filled while the previous ones are programmed, `LLKERNEL_IMPL_flushCopyToROM()` waits until all of them are
+ * programmed. Default is 2.
+ */
+#if !defined(LLKERNEL_WRITE_BUFFER_COUNT)
+#define LLKERNEL_WRITE_BUFFER_COUNT  2u
+#endif // LLKERNEL_WRITE_BUFFER_COUNT
+
+#if (1u > LLKERNEL_WRITE_BUFFER_COUNT)
+	#error "LLKERNEL_WRITE_BUFFER_COUNT must be greater than 0"
+#endif
+
+/**
+ * @brief Number of features whose pages `LLKERNEL_IMPL_copyToROM()` assembles at the same time. When the copies of
+ * several features are interleaved, the partial page of a feature is kept in one of the
+ * LLKERNEL_FLASH_NB_WRITE_CONTEXTS - 1 additional page buffers while another feature is copied, instead of being
+ * programmed and read back when its copy goes on. When all the buffers are used, the page kept for the longest time
+ * is programmed. `LLKERNEL_IMPL_flushCopyToROM()` programs all the kept pages. The CRC computed with
+ * LLKERNEL_FLASH_VERIFY_CRC and the progress recorded with LLKERNEL_FLASH_RESUMABLE_INSTALL are kept for as many
+ * features, the ones of the feature copied for the longest time are dropped. Default is 1, a partial page is
+ * programmed as soon as another page is copied.
+ */
+#if !defined(LLKERNEL_FLASH_NB_WRITE_CONTEXTS)
+#define LLKERNEL_FLASH_NB_WRITE_CONTEXTS  1u
+#endif // LLKERNEL_FLASH_NB_WRITE_CONTEXTS
+
+#if (1u > LLKERNEL_FLASH_NB_WRITE_CONTEXTS)
+	#error "LLKERNEL_FLASH_NB_WRITE_CONTEXTS must be greater than 0"
+#endif
+
+/**
+ * @brief Locks the mutex serializing the calls of the `LLKERNEL_IMPL_*()` functions and of the `LLKERNEL_flash_*()`
+ * functions of LLKERNEL_flash.h when they are called from several tasks, with `xSemaphoreTakeRecursive()` with
+ * FreeRTOS for example. The feature table, the KF area extents and the page buffers are only accessed with the mutex
+ * locked. These functions call each other: the mutex must be recursive. Default does nothing.
+ */
+#if !defined(LLKERNEL_FLASH_LOCK)
+#define LLKERNEL_FLASH_LOCK()  ((void)0)
+#endif // LLKERNEL_FLASH_LOCK
+
+/**
+ * @brief Unlocks the mutex locked by LLKERNEL_FLASH_LOCK(). Default does nothing.
+ */
+#if !defined(LLKERNEL_FLASH_UNLOCK)
+#define LLKERNEL_FLASH_UNLOCK()  ((void)0)
+#endif // LLKERNEL_FLASH_UNLOCK
+
+/**
+ * @brief Verification mode of the pages programmed by `LLKERNEL_IMPL_copyToROM()`:
+ * - LLKERNEL_FLASH_VERIFY_PAGE: each page is read back in memory mapped mode after its program (default).
+ * - LLKERNEL_FLASH_VERIFY_DEFERRED: the pages programmed by a call are read back at once at the end of the call, the
+ * memory mapped mode is enabled once per call instead of once per page.
+ * - LLKERNEL_FLASH_VERIFY_CRC: the CRC-32 of the copied data is computed on the fly and compared with the CRC-32 of
+ * the ROM area by `LLKERNEL_IMPL_flushCopyToROM()` once the whole ROM area is copied in increasing address order. The
+ * CRC-32 is then stored in the feature header.
+ */
+#if !defined(LLKERNEL_FLASH_VERIFY_MODE)
+#define LLKERNEL_FLASH_VERIFY_MODE  LLKERNEL_FLASH_VERIFY_PAGE
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+
+/**
+ * @brief Set to 1 when the flash controller implements `flash_ctrl_crc()`, to compute the CRC-32 of the flash
+ * content with a CRC peripheral or DMA instead of the software implementation. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_CTRL_CRC)
+#define LLKERNEL_FLASH_CTRL_CRC  0
+#endif // LLKERNEL_FLASH_CTRL_CRC
+
+/**
+ * @brief Set to 1 to check the ROM area of the installed features against the CRC-32 stored in their header by
+ * LLKERNEL_FLASH_VERIFY_CRC when the KF area is mounted. A corrupted feature is not loaded and its ROM area is freed.
+ * The whole KF area is read at boot. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_CRC_MOUNT_CHECK)
+#define LLKERNEL_FLASH_CRC_MOUNT_CHECK  0
+#endif // LLKERNEL_FLASH_CRC_MOUNT_CHECK
+
+/**
+ * @brief Set to 1 to enable `LLKERNEL_flash_update_feature()`, which updates an installed feature in place by
+ * programming only the pages that differ from the flash content. A subsector is erased only when one of its pages
+ * differs. Uses an additional RAM buffer of LLKERNEL_FLASH_SUBSECTOR_SIZE bytes. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_DELTA_UPDATE)
+#define LLKERNEL_FLASH_DELTA_UPDATE  0
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+
+/**
+ * @brief Set to 1 to enable `LLKERNEL_flash_stage_feature()` and `LLKERNEL_flash_commit_staged_feature()`, which install
+ * a new version of a feature in a free area of the KF area while the installed version stays usable, then switch to
+ * the new version once it has been completely copied and checked. Needs room for both versions. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_STAGED_UPDATE)
+#define LLKERNEL_FLASH_STAGED_UPDATE  0
+#endif // LLKERNEL_FLASH_STAGED_UPDATE
+
+/**
+ * @brief Set to 1 to erase only the header subsector of a feature in `LLKERNEL_IMPL_allocateFeature()`. The next
+ * subsectors are erased by `LLKERNEL_IMPL_copyToROM()` just before the first data copied into them, which spreads the
+ * erase time over the download. The subsectors that have not been copied are erased when the next feature is allocated
+ * or updated. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_LAZY_ERASE)
+#define LLKERNEL_FLASH_LAZY_ERASE  0
+#endif // LLKERNEL_FLASH_LAZY_ERASE
+
+/**
+ * @brief Set to 1 to record the progress of the installation of a feature in its header, so that an installation
+ * interrupted by a reset or by the loss of the download link is resumed with `LLKERNEL_flash_resume_install()` instead
+ * of being restarted. The progress is recorded by clearing bits of the header each time 1/95 of the feature area, at
+ * least one subsector, has been programmed. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_RESUMABLE_INSTALL)
+#define LLKERNEL_FLASH_RESUMABLE_INSTALL  0
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+
+/**
+ * @brief Set to 1 to enable `LLKERNEL_flash_inflate_start()` and `LLKERNEL_flash_inflate_copy()`, which decompress a
+ * feature compressed with the LZSS format of heatshrink while it is copied into the flash. The feature is stored
+ * uncompressed. Default is 0.
+ */
+#if !defined(LLKERNEL_FLASH_INFLATE)
+#define LLKERNEL_FLASH_INFLATE  0
+#endif // LLKERNEL_FLASH_INFLATE
+
+/**
+ * @brief Size of the decompression window, as a power of 2: the window uses 2^LLKERNEL_FLASH_INFLATE_WINDOW_BITS bytes
+ * of RAM. It must match the `-w` option of the heatshrink encoder. Default is 10 (1 KB).
+ */
+#if !defined(LLKERNEL_FLASH_INFLATE_WINDOW_BITS)
+#define LLKERNEL_FLASH_INFLATE_WINDOW_BITS  10u
+#endif // LLKERNEL_FLASH_INFLATE_WINDOW_BITS
+
+/**
+ * @brief Number of bits of the back-reference lengths. It must match the `-l` option of the heatshrink encoder.
+ * Default is 4.
+ */
+#if !defined(LLKERNEL_FLASH_INFLATE_LOOKAHEAD_BITS)
+#define LLKERNEL_FLASH_INFLATE_LOOKAHEAD_BITS  4u
+#endif // LLKERNEL_FLASH_INFLATE_LOOKAHEAD_BITS
+
+#if (1 == LLKERNEL_FLASH_INFLATE)
+#if (4u > LLKERNEL_FLASH_INFLATE_WINDOW_BITS) || (15u < LLKERNEL_FLASH_INFLATE_WINDOW_BITS)
+	#error "LLKERNEL_FLASH_INFLATE_WINDOW_BITS must be between 4 and 15"
+#endif
+#if (3u > LLKERNEL_FLASH_INFLATE_LOOKAHEAD_BITS) || \
+	(LLKERNEL_FLASH_INFLATE_WINDOW_BITS <= LLKERNEL_FLASH_INFLATE_LOOKAHEAD_BITS)
+	#error "LLKERNEL_FLASH_INFLATE_LOOKAHEAD_BITS must be at least 3 and lower than LLKERNEL_FLASH_INFLATE_WINDOW_BITS"
+#endif
+#endif // LLKERNEL_FLASH_INFLATE
+
+/**
+ * @brief Set to 1 to count the flash operations and measure their duration, see `LLKERNEL_flash_get_stats()`.
+ * Default is 0, the flash controller functions are then called directly.
+ */
+#if !defined(LLKERNEL_FLASH_STATS)
+#define LLKERNEL_FLASH_STATS  0
+#endif // LLKERNEL_FLASH_STATS
+
+/**
+ * @brief Time source of the flash operation statistics, a free-running 32-bit counter such as the cycle counter of the
+ * MCU (`DWT->CYCCNT` on Cortex-M). It must be defined when LLKERNEL_FLASH_ERASE_YIELD and
+ * LLKERNEL_FLASH_CTRL_ERASE_SUSPEND are 1, to time the erases. Default returns 0, only the operations are counted.
+ */
+#if !defined(LLKERNEL_FLASH_STATS_GET_TIME)
+#define LLKERNEL_FLASH_STATS_GET_TIME()  (0u)
+// The default time source does not measure the duration of the erases.
+#define LLKERNEL_FLASH_STATS_NO_TIME_SOURCE
+#endif // LLKERNEL_FLASH_STATS_GET_TIME
+
+#if (1 == LLKERNEL_FLASH_ERASE_YIELD) && (1 == LLKERNEL_FLASH_CTRL_ERASE_SUSPEND) \
+    && defined(LLKERNEL_FLASH_STATS_NO_TIME_SOURCE)
+	#error "LLKERNEL_FLASH_STATS_GET_TIME must be defined when the erases can be suspended"
+#endif
+
 /**
  * @brief Magic number used for making features as used.
  */
@@ -124,12 +518,31 @@ extern "C" {
 #endif // LLKERNEL_FEATURE_USED_MAGIC_NUMBER
 
 /**
- * @brief Magic number used for making features as removed.
+ * @brief Magic number used for making features as removed. A feature is removed by programming this value over
+ * LLKERNEL_FEATURE_USED_MAGIC_NUMBER without erasing the flash, so its bits set to 1 must also be set to 1 in
+ * LLKERNEL_FEATURE_USED_MAGIC_NUMBER.
  */
 #if !defined(LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER)
-#define LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER        0x3ADCA7u
+#define LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER        0x1854A0u
 #endif // LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER
 
+#if (0u != (LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER & ~LLKERNEL_FEATURE_USED_MAGIC_NUMBER))
+	#error "LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER must only clear bits of LLKERNEL_FEATURE_USED_MAGIC_NUMBER"
+#endif
+
+/**
+ * @brief Magic number used for marking the new version of a feature being installed by a staged update. The update is
+ * committed by programming LLKERNEL_FEATURE_USED_MAGIC_NUMBER over this value without erasing the flash, so the bits
+ * set to 1 in LLKERNEL_FEATURE_USED_MAGIC_NUMBER must also be set to 1 in this value.
+ */
+#if !defined(LLKERNEL_FEATURE_STAGED_MAGIC_NUMBER)
+#define LLKERNEL_FEATURE_STAGED_MAGIC_NUMBER         0x5ABCF7FBu
+#endif // LLKERNEL_FEATURE_STAGED_MAGIC_NUMBER
+
+#if (0u != (LLKERNEL_FEATURE_USED_MAGIC_NUMBER & ~LLKERNEL_FEATURE_STAGED_MAGIC_NUMBER))
+	#error "LLKERNEL_FEATURE_USED_MAGIC_NUMBER must only clear bits of LLKERNEL_FEATURE_STAGED_MAGIC_NUMBER"
+#endif
+
 // ----------------------------------------------------------------------------
 // End
 // ----------------------------------------------------------------------------
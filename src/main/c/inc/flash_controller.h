@@ -34,6 +34,10 @@ extern "C" {
 #define FLASH_CTRL_OK          ((uint32_t)0x00) /** < Successful execution. */
 // cppcheck-suppress [misra-c2012-2.5]: false positive, used in the implementation file.
 #define FLASH_CTRL_ERROR       ((uint32_t)0x01) /** < Error during execution. */
+// cppcheck-suppress [misra-c2012-2.5]: false positive, used in the implementation file.
+#define FLASH_CTRL_NOT_BLANK   ((uint32_t)0x02) /** < Blank-check done, the area is not erased. */
+// cppcheck-suppress [misra-c2012-2.5]: false positive, used in the implementation file.
+#define FLASH_CTRL_BUSY        ((uint32_t)0x03) /** < Asynchronous operation in progress. */
 
 // --------------------------------------------------------------------------------
 //          Additional information about flash memory areas nomenclature
@@ -43,11 +47,54 @@ extern "C" {
  * Subsector: It must correspond to the Erase Unit Size, the smallest erasable unit in the selected memory.
  */
 
+/*
+ * Block: Optional erase unit larger than a subsector (typically 32 KB or 64 KB) that the memory erases faster than the
+ * equivalent amount of subsectors. A block is aligned on its size and contains an integer number of subsectors.
+ */
+
 /*
  * Page: When writing, flash memory devices temporarily store the data to be written in an internal page buffer.
  * The page size must correspond to the biggest writeable unit in the selected memory.
  */
 
+// -----------------------------------------------------------------------------
+// Typedefs
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Flash memory device holding a KF area, when LLKERNEL_FLASH_NB_DEVICES is greater than 1. The functions have
+ * the same contract as the `flash_ctrl_*` functions of the same name below, for the device. The optional functions are
+ * only called when the corresponding LLKERNEL_FLASH_CTRL_* configuration is set to 1, they must then be implemented for
+ * all the devices.
+ */
+typedef struct {
+	uint32_t (*page_write)(uint8_t *pData, uint32_t addr, uint32_t size);
+	uint32_t (*erase_subsector)(uint32_t addr);
+	uint32_t (*enable_memory_mapped_mode)(void);
+	uint32_t (*disable_memory_mapped_mode)(void);
+	uint32_t (*get_subsector_address)(uint32_t address);
+	uint32_t (*get_page_address)(uint32_t address);
+	uint32_t (*blank_check)(uint32_t addr, uint32_t size); /**< Optional. */
+	uint32_t (*erase_block)(uint32_t addr); /**< Optional. */
+	uint32_t (*page_write_async)(uint8_t *pData, uint32_t addr, uint32_t size); /**< Optional. */
+	uint32_t (*get_operation_status)(void); /**< Optional. */
+	uint32_t (*write_range)(uint8_t *pData, uint32_t addr, uint32_t size); /**< Optional. */
+	uint32_t (*crc)(uint32_t addr, uint32_t size, uint32_t *crc); /**< Optional. */
+	uint32_t (*erase_async)(uint32_t addr, uint32_t size); /**< Optional. */
+	uint32_t (*erase_suspend)(void); /**< Optional. */
+	uint32_t (*erase_resume)(void); /**< Optional. */
+	uint32_t subsector_size;
+	uint32_t page_size;
+	uint32_t block_size; /**< Only used when LLKERNEL_FLASH_CTRL_BLOCK_ERASE is set to 1. */
+	uint32_t kf_start_address;
+	uint32_t kf_end_address;
+	/**
+	 * Size of the largest feature stored in the device, header included, 0 for no limit. Small features are placed on
+	 * a fast device listed first by setting this size, larger features on the next devices.
+	 */
+	uint32_t max_feature_size;
+} flash_ctrl_device_t;
+
 // --------------------------------------------------------------------------------
 //                        Functions that must be implemented
 // --------------------------------------------------------------------------------
@@ -62,7 +109,8 @@ uint32_t flash_ctrl_startup(void);
 
 /**
  * @brief  Writes in the flash at the beginning of a page the given content in parameters. The write size should not
- * exceed the page's size.
+ * exceed the page's size. When LLKERNEL_FLASH_PROGRAM_UNIT_SIZE is smaller than the page size, the address and the size
+ * are multiples of LLKERNEL_FLASH_PROGRAM_UNIT_SIZE and the write may start inside a page, without crossing its end.
  * @param  pData Pointer to the data to be written
  * @param  addr Write start address, offset in MCU memory
  * @param  size Size of the data to be written
@@ -141,6 +189,143 @@ uint32_t flash_ctrl_get_kf_start_address(void);
  */
 uint32_t flash_ctrl_get_kf_end_address(void);
 
+// --------------------------------------------------------------------------------
+//                                Optional functions
+// --------------------------------------------------------------------------------
+
+/**
+ * @brief  Obtains the devices holding a KF area, the LLKERNEL implementation then calls the functions of the
+ * devices instead of the other functions of this file. The devices are listed in placement order: a new feature is
+ * allocated in the first device where it fits. The KF areas are sorted by address and must not overlap.
+ *
+ * @retval An array of LLKERNEL_FLASH_NB_DEVICES devices, it must stay valid.
+ *
+ * @note Only called when LLKERNEL_FLASH_NB_DEVICES is greater than 1.
+ */
+const flash_ctrl_device_t *flash_ctrl_get_devices(void);
+
+/**
+ * @brief  Checks if a flash area is erased, using the blank-check feature of the flash memory device.
+ * @param  addr Start address of the area to check, offset in MCU memory
+ * @param  size Size of the area to check
+ *
+ * @retval FLASH_CTRL_OK if the area is erased, FLASH_CTRL_NOT_BLANK if it is not, FLASH_CTRL_ERROR if an error occurs.
+ *
+ * @note Only called when LLKERNEL_FLASH_CTRL_BLANK_CHECK and LLKERNEL_FLASH_BLANK_CHECK or LLKERNEL_FLASH_SCRUB are
+ * set to 1. The memory mapped mode is enabled when this function is called and must be enabled when it returns.
+ */
+uint32_t flash_ctrl_blank_check(uint32_t addr, uint32_t size);
+
+/**
+ * @brief  Obtains the size of a block, the largest erase unit of the flash memory device.
+ *
+ * @retval The block size in bytes, a multiple of the subsector size.
+ *
+ * @note Only called when LLKERNEL_FLASH_CTRL_BLOCK_ERASE is set to 1.
+ */
+uint32_t flash_ctrl_get_block_size(void);
+
+/**
+ * @brief  Erases a block of the flash memory that starts at the address given in parameters.
+ * @param  addr Block address to erase, aligned on the block size, offset in MCU memory
+ *
+ * @retval FLASH_CTRL_OK on success, FLASH_CTRL_ERROR if an error occurs.
+ *
+ * @attention If a cache is enabled, invalidate the cache of the memory area updated before the return statement.
+ * @note Only called when LLKERNEL_FLASH_CTRL_BLOCK_ERASE is set to 1.
+ */
+uint32_t flash_ctrl_erase_block(uint32_t addr);
+
+/**
+ * @brief  Starts to write in the flash at the beginning of a page the given content in parameters, and returns without
+ * waiting for the end of the program. The write size should not exceed the page's size.
+ * @param  pData Pointer to the data to be written, the data must not be modified until the end of the program
+ * @param  addr Write start address, offset in MCU memory
+ * @param  size Size of the data to be written
+ *
+ * @retval FLASH_CTRL_OK if the program is started, FLASH_CTRL_ERROR if an error occurs.
+ *
+ * @note The memory mapped mode is disabled when this function is called, and is enabled by the LLKERNEL
+ * implementation only once flash_ctrl_get_operation_status() does not return FLASH_CTRL_BUSY anymore.
+ * @note Only called when LLKERNEL_FLASH_CTRL_ASYNC is set to 1.
+ */
+uint32_t flash_ctrl_page_write_async(uint8_t *pData, uint32_t addr, uint32_t size);
+
+/**
+ * @brief  Obtains the status of the operation started asynchronously. The completion can be polled from the flash
+ * memory device status register, or signaled by the transfer complete interrupt of the controller.
+ *
+ * @retval FLASH_CTRL_BUSY while the operation is in progress, then FLASH_CTRL_OK on success or FLASH_CTRL_ERROR if
+ * the operation failed.
+ *
+ * @note If a cache is enabled, invalidate the cache of the memory area updated before returning the end of the
+ * operation.
+ * @note Only called when LLKERNEL_FLASH_CTRL_ASYNC or LLKERNEL_FLASH_CTRL_ERASE_SUSPEND is set to 1.
+ */
+uint32_t flash_ctrl_get_operation_status(void);
+
+/**
+ * @brief  Writes in the flash the given content in parameters, in one operation spanning several pages (DMA transfer
+ * with automatic handling of the page boundaries for example). The function returns once the data are programmed.
+ * @param  pData Pointer to the data to be written
+ * @param  addr Write start address, offset in MCU memory, aligned on a page
+ * @param  size Size of the data to be written, it can exceed the page's size
+ *
+ * @retval FLASH_CTRL_OK on success, FLASH_CTRL_ERROR if an error occurs.
+ *
+ * @note The memory mapped mode is disabled when this function is called.
+ * @note Only called when LLKERNEL_FLASH_CTRL_WRITE_RANGE is set to 1.
+ */
+uint32_t flash_ctrl_write_range(uint8_t *pData, uint32_t addr, uint32_t size);
+
+/**
+ * @brief  Computes the CRC-32 of a flash area: IEEE 802.3 polynomial 0x04C11DB7 with reflected input and output,
+ * initial value 0xFFFFFFFF and final value inverted (same as zlib `crc32()`).
+ * @param  addr Start address of the area, offset in MCU memory
+ * @param  size Size of the area in bytes
+ * @param  crc Pointer to the computed CRC-32
+ *
+ * @retval FLASH_CTRL_OK on success, FLASH_CTRL_ERROR if an error occurs.
+ *
+ * @note The memory mapped mode is enabled when this function is called.
+ * @note Only called when LLKERNEL_FLASH_CTRL_CRC is set to 1.
+ */
+uint32_t flash_ctrl_crc(uint32_t addr, uint32_t size, uint32_t *crc);
+
+/**
+ * @brief  Starts the erase of a subsector or of a block of the flash memory, and returns without waiting for the end
+ * of the erase. The end of the erase is polled with flash_ctrl_get_operation_status().
+ * @param  addr Address of the subsector or of the block to erase, aligned on its size, offset in MCU memory
+ * @param  size Size of the area to erase, the subsector size or the block size
+ *
+ * @retval FLASH_CTRL_OK if the erase is started, FLASH_CTRL_ERROR if an error occurs.
+ *
+ * @note The memory mapped mode is disabled when this function is called.
+ * @note Only called when LLKERNEL_FLASH_CTRL_ERASE_SUSPEND and LLKERNEL_FLASH_ERASE_YIELD are set to 1.
+ */
+uint32_t flash_ctrl_erase_async(uint32_t addr, uint32_t size);
+
+/**
+ * @brief  Suspends the erase in progress, and returns once the flash memory can be read.
+ *
+ * @retval FLASH_CTRL_OK on success, FLASH_CTRL_ERROR if an error occurs.
+ *
+ * @note The memory mapped mode is disabled when this function is called, the LLKERNEL implementation enables it while
+ * the erase is suspended.
+ * @note Only called when LLKERNEL_FLASH_CTRL_ERASE_SUSPEND and LLKERNEL_FLASH_ERASE_YIELD are set to 1.
+ */
+uint32_t flash_ctrl_erase_suspend(void);
+
+/**
+ * @brief  Resumes the suspended erase, its end is polled with flash_ctrl_get_operation_status().
+ *
+ * @retval FLASH_CTRL_OK on success, FLASH_CTRL_ERROR if an error occurs.
+ *
+ * @note The memory mapped mode is disabled when this function is called.
+ * @note Only called when LLKERNEL_FLASH_CTRL_ERASE_SUSPEND and LLKERNEL_FLASH_ERASE_YIELD are set to 1.
+ */
+uint32_t flash_ctrl_erase_resume(void);
+
 // -----------------------------------------------------------------------------
 // EOF
 // -----------------------------------------------------------------------------
@@ -30,6 +30,122 @@
 
 #define UNUSED_RETURN(x) (void)(x)
 
+// Each used extent can be surrounded by free extents.
+#define LLKERNEL_MAX_NB_EXTENTS ((2u * LLKERNEL_MAX_NB_FEATURES) + 1u)
+
+// CRC-32 computation is needed to check the installed features.
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE) || (1 == LLKERNEL_FLASH_CRC_MOUNT_CHECK)
+#define LLKERNEL_FLASH_CRC 1
+#else
+#define LLKERNEL_FLASH_CRC 0
+#endif
+
+// The blank-check of the flash is needed to skip the erase of blank subsectors.
+#if (1 == LLKERNEL_FLASH_BLANK_CHECK) || (1 == LLKERNEL_FLASH_SCRUB)
+#define LLKERNEL_FLASH_IS_BLANK_NEEDED 1
+#else
+#define LLKERNEL_FLASH_IS_BLANK_NEEDED 0
+#endif
+
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+// Number of granules of a feature area whose programming is recorded in the 96 bits of the install_progress words of
+// its header. The first bit is cleared when the progress is recorded, the next ones as the granules are programmed.
+#define LLKERNEL_INSTALL_NB_GRANULES 95u
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+
+#if (1 == LLKERNEL_FLASH_SCRUB)
+// Number of subsectors of the KF area tracked as scrubbed.
+#define LLKERNEL_SCRUB_NB_SUBSECTORS (LLKERNEL_KF_BLOCK_SIZE / LLKERNEL_FLASH_SUBSECTOR_SIZE)
+#endif // LLKERNEL_FLASH_SCRUB
+
+#if (1 == LLKERNEL_FLASH_STATS)
+#define LLKERNEL_STATS_ADD(field, value) (llkernel_stats.field += (value))
+#define LLKERNEL_STATS_ADD_TIME(field, start_time) llkernel_stats_add_time(&llkernel_stats.field, (start_time))
+#else
+#define LLKERNEL_STATS_ADD(field, value) ((void)0)
+#define LLKERNEL_STATS_ADD_TIME(field, start_time) ((void)(start_time))
+#endif // LLKERNEL_FLASH_STATS
+
+#if (1 == LLKERNEL_FLASH_TRACE)
+#define LLKERNEL_TRACE_EVENT(id, address, size) llkernel_trace_event((id), (address), (size))
+#else
+#define LLKERNEL_TRACE_EVENT(id, address, size) ((void)0)
+#endif // LLKERNEL_FLASH_TRACE
+
+// The flash controller functions are called through wrappers updating the statistics and the trace.
+#if (1 == LLKERNEL_FLASH_STATS) || (1 == LLKERNEL_FLASH_TRACE)
+#define LLKERNEL_FLASH_CTRL_WRAPPERS 1
+#else
+#define LLKERNEL_FLASH_CTRL_WRAPPERS 0
+#endif
+
+// The CRC and the installation progress of the features whose copies are interleaved are kept in stream contexts.
+#if (1u < LLKERNEL_FLASH_NB_WRITE_CONTEXTS) && \
+	((LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE) || (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL))
+#define LLKERNEL_STREAM_CONTEXTS 1
+#else
+#define LLKERNEL_STREAM_CONTEXTS 0
+#endif
+
+#if (0 == LLKERNEL_FLASH_CTRL_WRAPPERS)
+// The flash controller functions are called directly.
+#define llkernel_ctrl_page_write flash_ctrl_page_write
+#define llkernel_ctrl_erase_subsector flash_ctrl_erase_subsector
+#define llkernel_ctrl_erase_block flash_ctrl_erase_block
+#define llkernel_ctrl_enable_memory_mapped_mode flash_ctrl_enable_memory_mapped_mode
+#define llkernel_ctrl_disable_memory_mapped_mode flash_ctrl_disable_memory_mapped_mode
+#define llkernel_ctrl_page_write_async flash_ctrl_page_write_async
+#define llkernel_ctrl_write_range flash_ctrl_write_range
+#endif // LLKERNEL_FLASH_CTRL_WRAPPERS
+
+#if (1 == LLKERNEL_FLASH_STATIC_GEOMETRY)
+// The geometry is known at compile time, the page and subsector addresses are computed with masks.
+#define flash_ctrl_get_page_size() (LLKERNEL_FLASH_PAGE_SIZE)
+#define flash_ctrl_get_subsector_size() (LLKERNEL_FLASH_SUBSECTOR_SIZE)
+#define flash_ctrl_get_page_address(address) ((address) & ~(LLKERNEL_FLASH_PAGE_SIZE - 1u))
+#define flash_ctrl_get_subsector_address(address) ((address) & ~(LLKERNEL_FLASH_SUBSECTOR_SIZE - 1u))
+#endif // LLKERNEL_FLASH_STATIC_GEOMETRY
+
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+// The flash controller functions are the ones of the selected device, see llkernel_device_select().
+#define flash_ctrl_page_write(pData, addr, size) (llkernel_get_device()->page_write((pData), (addr), (size)))
+#define flash_ctrl_erase_subsector(addr) (llkernel_get_device()->erase_subsector(addr))
+#define flash_ctrl_enable_memory_mapped_mode() (llkernel_get_device()->enable_memory_mapped_mode())
+#define flash_ctrl_disable_memory_mapped_mode() (llkernel_get_device()->disable_memory_mapped_mode())
+#define flash_ctrl_get_subsector_address(address) (llkernel_get_device()->get_subsector_address(address))
+#define flash_ctrl_get_page_address(address) (llkernel_get_device()->get_page_address(address))
+#define flash_ctrl_get_subsector_size() (llkernel_get_device()->subsector_size)
+#define flash_ctrl_get_page_size() (llkernel_get_device()->page_size)
+#define flash_ctrl_get_kf_start_address() (llkernel_get_device()->kf_start_address)
+#define flash_ctrl_get_kf_end_address() (llkernel_get_device()->kf_end_address)
+#define flash_ctrl_blank_check(addr, size) (llkernel_get_device()->blank_check((addr), (size)))
+#define flash_ctrl_get_block_size() (llkernel_get_device()->block_size)
+#define flash_ctrl_erase_block(addr) (llkernel_get_device()->erase_block(addr))
+#define flash_ctrl_page_write_async(pData, addr, size) \
+	(llkernel_get_device()->page_write_async((pData), (addr), (size)))
+#define flash_ctrl_get_operation_status() (llkernel_get_device()->get_operation_status())
+#define flash_ctrl_write_range(pData, addr, size) (llkernel_get_device()->write_range((pData), (addr), (size)))
+#define flash_ctrl_crc(addr, size, crc) (llkernel_get_device()->crc((addr), (size), (crc)))
+#define flash_ctrl_erase_async(addr, size) (llkernel_get_device()->erase_async((addr), (size)))
+#define flash_ctrl_erase_suspend() (llkernel_get_device()->erase_suspend())
+#define flash_ctrl_erase_resume() (llkernel_get_device()->erase_resume())
+#else
+// The single device is always selected.
+#define llkernel_device_select(index) ((void)0)
+#define llkernel_device_select_address(address) ((void)0)
+#endif // LLKERNEL_FLASH_NB_DEVICES
+
+#if (1 == LLKERNEL_FLASH_INFLATE)
+// Size of the decompression window, a power of 2.
+#define LLKERNEL_INFLATE_WINDOW_SIZE (1u << LLKERNEL_FLASH_INFLATE_WINDOW_BITS)
+#endif // LLKERNEL_FLASH_INFLATE
+
+// CRC-32 (IEEE 802.3) initial value, also the value of the header CRC when it has not been computed.
+#define LLKERNEL_CRC32_INIT 0xFFFFFFFFu
+
+// Size of the feature header written by the versions 1.x, whose features are not mounted anymore.
+#define LLKERNEL_LEGACY_FEATURE_HEADER_SIZE 32u
+
 // -----------------------------------------------------------------------------
 // Typedef and Structure
 // -----------------------------------------------------------------------------
@@ -41,22 +157,197 @@ typedef struct {
 	uint32_t rom_size;
 	uint32_t ram_address;
 	uint32_t ram_size;
-	uint32_t feature_index;
-	uint32_t reserved; // Reserved word to align the rom area over 16 bytes.
+	uint32_t erase_count; // Number of erases of the most erased subsector of the ROM area, kept once removed.
+	uint32_t crc; // CRC-32 of the ROM area, LLKERNEL_CRC32_INIT if not computed.
+	uint32_t replaced_address; // Handle of the feature replaced by a staged update being committed, 0 or 0xFFFFFFFF.
+	// Installation progress when LLKERNEL_FLASH_RESUMABLE_INSTALL is 1, a thermometer code whose bits are only cleared:
+	// bit 0 of word 0 is cleared when the progress is recorded, then bit (n % 32) of word (n / 32) once the granule n
+	// (1 to LLKERNEL_INSTALL_NB_GRANULES) of the feature area is programmed. The 3 words are 0xFFFFFFFF when the
+	// progress is not recorded, the feature has then been installed without it. Also aligns the rom area over 16 bytes.
+	uint32_t install_progress[3];
 } feature_header_t;
 
+// Range of subsectors of the KF area, either allocated to a feature or free.
+typedef struct {
+	uint32_t address; // Start address of the extent, aligned on a subsector.
+	uint32_t nb_subsectors;
+	uint32_t erase_count; // Highest erase count known for the subsectors of the extent.
+	bool used;
+} kf_extent_t;
+
+#if (1 == LLKERNEL_FLASH_INFLATE)
+// Field of the compressed stream read by the decompression.
+typedef enum {
+	INFLATE_TAG, // 1 bit: 1 for a literal, 0 for a back-reference
+	INFLATE_LITERAL, // 8 bits: the decompressed byte
+	INFLATE_INDEX, // LLKERNEL_FLASH_INFLATE_WINDOW_BITS bits: back-reference distance minus 1
+	INFLATE_COUNT, // LLKERNEL_FLASH_INFLATE_LOOKAHEAD_BITS bits: back-reference length minus 1
+} inflate_field_t;
+#endif // LLKERNEL_FLASH_INFLATE
+
+#if (1u < LLKERNEL_FLASH_NB_WRITE_CONTEXTS)
+// Page assembled for a feature while another feature is copied, see llkernel_write_contexts_select().
+typedef struct {
+	uint8_t buffer[LLKERNEL_FLASH_PAGE_SIZE];
+	uint8_t *target_page_address; // destination ROM page address of the buffer, NULL if the context is free
+	uint32_t offset; // number of bytes stored in the buffer
+	uint32_t start; // offset of the first byte copied in the buffer
+	uint32_t last_use; // value of write_contexts_clock when the page was kept in the context
+} write_context_t;
+#endif // LLKERNEL_FLASH_NB_WRITE_CONTEXTS
+
+#if (1 == LLKERNEL_STREAM_CONTEXTS)
+// CRC and installation progress of a feature while another feature is copied, see llkernel_stream_contexts_select().
+typedef struct {
+	feature_header_t *feature_ptr; // feature of the copy state, NULL if the context is free
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+	feature_header_t *crc_feature_ptr;
+	uint32_t crc_next_address;
+	uint32_t crc_end_address;
+	uint32_t crc_value;
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+	feature_header_t *install_feature_ptr;
+	uint32_t install_next_address;
+	uint32_t install_nb_granules;
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+	uint32_t last_use; // value of stream_contexts_clock when the copy state was kept in the context
+} stream_context_t;
+#endif // LLKERNEL_STREAM_CONTEXTS
+
+// RAM copy of the information of an allocated feature, indexed by allocation index.
+typedef struct {
+	feature_header_t *header; // Feature handle.
+	uint32_t rom_address;
+	uint32_t rom_size;
+	uint32_t ram_address;
+	uint32_t ram_size;
+} feature_entry_t;
+
 // -----------------------------------------------------------------------------
 // Globals
 // -----------------------------------------------------------------------------
 
 // Variables for flash page write buffer and feature_globals
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+// Ring of page buffers: mem_writeBuffer is filled while the queued buffers are programmed in order.
+static uint8_t write_buffers[LLKERNEL_WRITE_BUFFER_COUNT][LLKERNEL_FLASH_PAGE_SIZE] = { 0 };
+static uint32_t write_buffers_page_address[LLKERNEL_WRITE_BUFFER_COUNT] = { 0 }; // destination of queued buffers
+static uint32_t write_buffers_head = 0; // index of mem_writeBuffer in the ring
+static uint32_t write_buffers_tail = 0; // index of the buffer being programmed
+static uint32_t write_buffers_nb_queued = 0; // number of buffers being programmed or waiting to be programmed
+static uint8_t *mem_writeBuffer = write_buffers[0];
+#else
 static uint8_t mem_writeBuffer[LLKERNEL_FLASH_PAGE_SIZE] = { 0 };
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
 static uint8_t *target_page_address = NULL; // destination ROM page address to write content of mem_writeBuffer to
 static uint32_t mem_writeBuffer_offset = 0; // number of bytes stored in mem_writeBuffer
-
-// features variables
-static feature_header_t *last_feature_ptr = NULL;
+static uint32_t mem_writeBuffer_start = 0; // offset of the first byte copied in mem_writeBuffer, the flash holds the
+                                           // bytes before
+#if (1u < LLKERNEL_FLASH_NB_WRITE_CONTEXTS)
+// Pages of the features whose copy is interleaved with the copy of the feature of target_page_address.
+static write_context_t write_contexts[LLKERNEL_FLASH_NB_WRITE_CONTEXTS - 1u];
+static uint32_t write_contexts_clock = 0; // incremented each time a page is kept in a write context
+#endif // LLKERNEL_FLASH_NB_WRITE_CONTEXTS
+// Pages of the last created feature not programmed since their erase, their content is known without reading them.
+static uint32_t erased_start_address = 0; // first erased page, the pages are programmed in address order
+static uint32_t erased_end_address = 0; // end address of the erased pages
+
+#if (1 == LLKERNEL_FLASH_LAZY_ERASE)
+// Subsectors of the last created feature erased by LLKERNEL_IMPL_copyToROM() before being programmed.
+static uint32_t lazy_feature_address = 0; // header of the feature
+static uint32_t lazy_erase_address = 0; // first subsector not erased yet
+static uint32_t lazy_erase_end_address = 0; // end address of the subsectors to erase, 0 if none
+#endif // LLKERNEL_FLASH_LAZY_ERASE
+
+// features variables, the allocated features are served from RAM once the KF area is mounted.
+static feature_entry_t features[LLKERNEL_MAX_NB_FEATURES];
 static uint32_t nb_features = 0;
+static bool kf_mounted = false;
+
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+// CRC-32 of the data copied into the feature being installed.
+static feature_header_t *crc_feature_ptr = NULL; // feature being installed, NULL if the CRC cannot be computed
+static uint32_t crc_next_address = 0; // address of the next byte expected in the ROM area
+static uint32_t crc_end_address = 0; // end address of the ROM area
+static uint32_t crc_value = 0;
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+
+// RAM areas of the features, not allocated in the stack, and ensuring that the buffer is aligned correctly.
+static uint8_t kernel_ram_buffer[LLKERNEL_RAM_BUFFER_SIZE]
+__attribute__((section(".bss.microej.llkernel")))
+__attribute__((aligned(LLKERNEL_RAM_ALIGN_SIZE)));
+
+#if (1 == LLKERNEL_FLASH_SCRUB)
+// One bit per subsector of the KF area, set when a free subsector is known to be erased.
+static uint32_t kf_scrubbed[(LLKERNEL_SCRUB_NB_SUBSECTORS + 31u) / 32u];
+#endif // LLKERNEL_FLASH_SCRUB
+
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+// Feature updated in place, see LLKERNEL_flash_update_feature().
+static feature_header_t *delta_feature_ptr = NULL; // feature being updated, NULL if no update in progress
+static uint32_t delta_end_address = 0; // end address of the subsectors of the feature being updated
+static uint32_t delta_page_address = 0; // last page written by the update, the pages are written in address order
+static uint32_t delta_erased_address = 0; // last subsector erased by the update, its pages are programmed directly
+static bool delta_erase_counted = false; // true once the erase count of the feature extent has been incremented
+// Content of the beginning of a subsector, kept while the subsector is erased.
+static uint8_t delta_subsector_buffer[LLKERNEL_FLASH_SUBSECTOR_SIZE]
+__attribute__((section(".bss.microej.llkernel")));
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+
+#if (1 == LLKERNEL_FLASH_STAGED_UPDATE)
+// New version of a feature, see LLKERNEL_flash_stage_feature(). Not in the feature table until committed.
+static feature_header_t *staged_feature_ptr = NULL; // NULL if no update is staged
+#endif // LLKERNEL_FLASH_STAGED_UPDATE
+
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+// Progress of the feature being installed, see LLKERNEL_flash_resume_install().
+static feature_header_t *install_feature_ptr = NULL; // NULL if the progress is not recorded
+static uint32_t install_next_address = 0; // end of the data copied in increasing address order
+static uint32_t install_nb_granules = 0; // number of granules recorded as programmed in the header
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+
+#if (1 == LLKERNEL_STREAM_CONTEXTS)
+// Copy states of the features whose copies are interleaved with the copy of the feature of the CRC and progress above.
+static stream_context_t stream_contexts[LLKERNEL_FLASH_NB_WRITE_CONTEXTS - 1u];
+static uint32_t stream_contexts_clock = 0; // incremented each time a copy state is kept in a stream context
+#endif // LLKERNEL_STREAM_CONTEXTS
+
+#if (1 == LLKERNEL_FLASH_INFLATE)
+// Decompression state, see LLKERNEL_flash_inflate_copy().
+static uint8_t *inflate_dest_ptr = NULL; // ROM address of the next decompressed byte to copy, NULL if not started
+static inflate_field_t inflate_field = INFLATE_TAG; // field being read
+static uint32_t inflate_field_value = 0; // bits of the field read so far
+static uint32_t inflate_field_nb_bits = 1; // number of bits of the field not read yet
+static uint32_t inflate_index = 0; // index of the back-reference being read
+static uint32_t inflate_write_index = 0; // index of the next decompressed byte in the window
+static uint32_t inflate_copy_index = 0; // index of the first decompressed byte of the window not copied yet
+// Last decompressed bytes, referenced by the back-references and copied from there into the flash.
+static uint8_t inflate_window[LLKERNEL_INFLATE_WINDOW_SIZE]
+__attribute__((section(".bss.microej.llkernel")));
+#endif // LLKERNEL_FLASH_INFLATE
+
+#if (1 == LLKERNEL_FLASH_STATS)
+// Flash operation statistics, see LLKERNEL_flash_get_stats().
+static LLKERNEL_flash_stats_t llkernel_stats;
+#endif // LLKERNEL_FLASH_STATS
+
+#if (1 == LLKERNEL_FLASH_TRACE)
+// Ring of the trace events, see LLKERNEL_flash_trace_read().
+static LLKERNEL_flash_trace_event_t trace_events[LLKERNEL_FLASH_TRACE_SIZE];
+static uint32_t trace_head = 0; // index of the next event recorded
+static uint32_t trace_nb_events = 0; // number of events not read yet
+static uint16_t trace_sequence = 0; // sequence number of the next event recorded
+#endif // LLKERNEL_FLASH_TRACE
+
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+// Device of the flash controller functions, NULL until the first one is selected.
+static const flash_ctrl_device_t *llkernel_device = NULL;
+#endif // LLKERNEL_FLASH_NB_DEVICES
+
+// KF area extents, sorted by address and covering the KF areas of all the devices.
+static kf_extent_t kf_extents[LLKERNEL_MAX_NB_EXTENTS];
+static uint32_t kf_nb_extents = 0;
 
 // Get LLKERNEL max number of dynamic features, a link-time option.
 extern void _java_max_nb_dynamic_features;
@@ -66,120 +357,765 @@ static uint32_t kernel_max_nb_dynamic_features = (uint32_t)(&_java_max_nb_dynami
 // Private functions
 // -----------------------------------------------------------------------------
 
-static inline bool is_feature_used(uint32_t feature_status);
-static inline bool is_feature_removed(uint32_t feature_status);
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+static const flash_ctrl_device_t *llkernel_get_device(void);
+static void llkernel_device_select(uint32_t index);
+static void llkernel_device_select_address(uint32_t address);
+#endif // LLKERNEL_FLASH_NB_DEVICES
+static uint32_t llkernel_device_find(uint32_t address);
 static uint32_t llkernel_get_kf_area_size(void);
-static uint32_t llkernel_get_feature_slot_size_rom_bytes(void);
-static uint32_t llkernel_get_next_aligned_ram_address(uint32_t address);
-static int llkernel_feature_is_in_last_kf_slot(feature_header_t *feature_ptr);
-static feature_header_t * llkernel_get_next_feature(feature_header_t *feature_ptr);
-static feature_header_t * llkernel_get_free_feature_slot(void);
+static uint32_t llkernel_get_nb_subsectors(uint32_t size);
+static uint32_t llkernel_get_aligned_ram_address(uint32_t address);
+static bool llkernel_is_page_erased(uint32_t page_address);
+static void llkernel_erased_pages_consume(uint32_t page_address, uint32_t size);
+#if (1 == LLKERNEL_FLASH_STATS)
+static void llkernel_stats_add_time(LLKERNEL_flash_op_stats_t *op_stats, uint32_t start_time);
+#endif // LLKERNEL_FLASH_STATS
+#if (1 == LLKERNEL_FLASH_TRACE)
+static void llkernel_trace_event(uint16_t id, uint32_t address, uint32_t size);
+#endif // LLKERNEL_FLASH_TRACE
+#if (1 == LLKERNEL_FLASH_CTRL_WRAPPERS)
+static uint32_t llkernel_ctrl_page_write(uint8_t *pData, uint32_t addr, uint32_t size);
+static uint32_t llkernel_ctrl_enable_memory_mapped_mode(void);
+static uint32_t llkernel_ctrl_disable_memory_mapped_mode(void);
+#if (0 == LLKERNEL_FLASH_ERASE_YIELD) || (0 == LLKERNEL_FLASH_CTRL_ERASE_SUSPEND)
+static uint32_t llkernel_ctrl_erase_subsector(uint32_t addr);
+#if (1 == LLKERNEL_FLASH_CTRL_BLOCK_ERASE)
+static uint32_t llkernel_ctrl_erase_block(uint32_t addr);
+#endif // LLKERNEL_FLASH_CTRL_BLOCK_ERASE
+#endif // !LLKERNEL_FLASH_ERASE_YIELD || !LLKERNEL_FLASH_CTRL_ERASE_SUSPEND
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+static uint32_t llkernel_ctrl_page_write_async(uint8_t *pData, uint32_t addr, uint32_t size);
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+#if (1 == LLKERNEL_FLASH_CTRL_WRITE_RANGE)
+static uint32_t llkernel_ctrl_write_range(uint8_t *pData, uint32_t addr, uint32_t size);
+#endif // LLKERNEL_FLASH_CTRL_WRITE_RANGE
+#endif // LLKERNEL_FLASH_CTRL_WRAPPERS
+static bool llkernel_is_feature_header_valid(const feature_header_t *feature_ptr, uint32_t status);
+#if (1 == LLKERNEL_FLASH_CRC_MOUNT_CHECK)
+static bool llkernel_is_feature_crc_valid(const feature_header_t *feature_ptr);
+#endif // LLKERNEL_FLASH_CRC_MOUNT_CHECK
+static void llkernel_features_add(feature_header_t *feature_ptr);
+static int32_t llkernel_features_find(int32_t handle);
+static void llkernel_features_remove(uint32_t index);
+static uint32_t llkernel_features_find_free_ram(uint32_t size);
+static bool llkernel_extents_append(uint32_t address, uint32_t nb_subsectors, bool used, uint32_t erase_count);
+static void llkernel_extents_remove(uint32_t index);
+static void llkernel_extents_compact(void);
+static uint32_t llkernel_extents_get_size(uint32_t index);
+static bool llkernel_extents_is_on_device(uint32_t index);
+static int32_t llkernel_extents_find(uint32_t address);
+static int32_t llkernel_extents_find_free(uint32_t nb_subsectors);
+static uint32_t llkernel_extents_reserve(uint32_t index, uint32_t nb_subsectors);
+static void llkernel_extents_release(uint32_t address);
 static const char *llkernel_error_code_to_str(uint32_t error_code);
-static uint32_t llkernel_flash_write(uint8_t *input_buffer, uint32_t flash_start_address, uint32_t size);
+#if (1 == LLKERNEL_FLASH_IS_BLANK_NEEDED)
+static bool llkernel_is_flash_blank(uint32_t flash_start_address, uint32_t size);
+#endif // LLKERNEL_FLASH_IS_BLANK_NEEDED
+#if (1 == LLKERNEL_FLASH_SCRUB)
+static bool llkernel_scrub_is_erased(uint32_t flash_start_address, uint32_t size);
+static void llkernel_scrub_set(uint32_t flash_start_address, uint32_t size, bool is_erased);
+static uint32_t llkernel_scrub_find_next(void);
+#endif // LLKERNEL_FLASH_SCRUB
+static uint32_t llkernel_erase_unit(uint32_t flash_address, uint32_t size);
+static uint32_t llkernel_get_erase_unit_size(uint32_t flash_address, uint32_t remaining);
+static uint32_t llkernel_flash_erase(uint32_t flash_start_address, uint32_t nb_subsectors);
+#if (1 == LLKERNEL_FLASH_LAZY_ERASE)
+static int32_t llkernel_lazy_erase(uint32_t start_address, uint32_t end_address);
+static void llkernel_lazy_erase_complete(void);
+#endif // LLKERNEL_FLASH_LAZY_ERASE
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+static int32_t llkernel_write_buffers_start(void);
+static int32_t llkernel_write_buffers_wait(uint32_t max_nb_queued);
+static int32_t llkernel_write_buffers_submit(uint32_t page_address);
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+static int32_t llkernel_flash_sync(void);
+#if (1 == LLKERNEL_FLASH_CTRL_WRITE_RANGE)
+static int32_t llkernel_flash_write_range(const uint8_t *src_ptr, uint32_t flash_start_address, uint32_t size);
+#endif // LLKERNEL_FLASH_CTRL_WRITE_RANGE
+static int32_t llkernel_write_buffer_flush(void);
+#if (1u < LLKERNEL_FLASH_NB_WRITE_CONTEXTS)
+static void llkernel_write_context_swap(write_context_t *context);
+static int32_t llkernel_write_contexts_select(int32_t extent_index);
+#endif // LLKERNEL_FLASH_NB_WRITE_CONTEXTS
+static void llkernel_write_buffers_discard(uint32_t start_address, uint32_t end_address);
+static uint32_t llkernel_page_write_range(uint8_t *pData, uint32_t page_address, uint32_t start_offset,
+                                          uint32_t end_offset);
+static uint32_t llkernel_flash_program_word(uint32_t address, uint32_t value);
+#if (1 == LLKERNEL_FLASH_CRC)
+static uint32_t llkernel_crc32_update(uint32_t crc, const uint8_t *data, uint32_t size);
+static uint32_t llkernel_flash_crc(uint32_t flash_start_address, uint32_t size, uint32_t *crc);
+#endif // LLKERNEL_FLASH_CRC
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+static void llkernel_crc_stream_update(const uint8_t *dest_ptr, const uint8_t *src_ptr, uint32_t size);
+static int32_t llkernel_crc_stream_check(void);
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (LLKERNEL_FLASH_VERIFY_DEFERRED == LLKERNEL_FLASH_VERIFY_MODE)
+static int32_t llkernel_verify_copy(const uint8_t *dest_ptr, const uint8_t *src_ptr, uint32_t size);
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+static uint32_t llkernel_install_get_granule_size(const feature_header_t *feature_ptr);
+static int32_t llkernel_install_get_nb_granules(const feature_header_t *feature_ptr);
+static uint32_t llkernel_install_get_progress(const feature_header_t *feature_ptr, uint32_t nb_granules);
+static void llkernel_install_record(uint32_t programmed_address);
+static void llkernel_install_update(const uint8_t *dest_ptr, uint32_t size);
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+#if (1 == LLKERNEL_STREAM_CONTEXTS)
+static feature_header_t * llkernel_stream_get_feature(void);
+static void llkernel_stream_context_swap(stream_context_t *context);
+static void llkernel_stream_contexts_select(const feature_header_t *feature_ptr);
+static int32_t llkernel_stream_contexts_complete(void);
+static void llkernel_stream_contexts_discard(const feature_header_t *feature_ptr);
+#endif // LLKERNEL_STREAM_CONTEXTS
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+static bool llkernel_delta_is_active(uint32_t address);
+static uint32_t llkernel_delta_page_write(uint8_t *pData, uint32_t page_address, uint32_t size);
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+static uint32_t llkernel_copy_page_write(uint8_t *pData, uint32_t page_address, uint32_t start_offset,
+                                         uint32_t end_offset);
+#if (1 == LLKERNEL_FLASH_INFLATE)
+static int32_t llkernel_inflate_copy_window(void);
+static int32_t llkernel_inflate_output(uint8_t byte);
+static int32_t llkernel_inflate_read_field(void);
+#endif // LLKERNEL_FLASH_INFLATE
+static uint32_t llkernel_feature_set_status(feature_header_t *feature_ptr, uint32_t status);
+static uint32_t llkernel_feature_create(uint32_t size_ROM, uint32_t ram_address, uint32_t size_RAM, uint32_t status,
+                                        uint32_t replaced_address);
+static void llkernel_features_complete_replacements(void);
+
+#if (1 == LLKERNEL_FLASH_STATS)
+/**
+ * @brief Updates the statistics of an operation class with an operation.
+ *
+ * @param[in] op_stats The statistics of the operation class.
+ * @param[in] start_time The value of LLKERNEL_FLASH_STATS_GET_TIME() before the operation.
+ */
+static void llkernel_stats_add_time(LLKERNEL_flash_op_stats_t *op_stats, uint32_t start_time) {
+	uint32_t time = (uint32_t)LLKERNEL_FLASH_STATS_GET_TIME() - start_time;
+	op_stats->count++;
+	op_stats->total_time += time;
+	if (time > op_stats->max_time) {
+		op_stats->max_time = time;
+	}
+}
+#endif // LLKERNEL_FLASH_STATS
+
+#if (1 == LLKERNEL_FLASH_TRACE)
+/**
+ * @brief Records an event in the trace ring, overwriting the oldest event when the ring is full.
+ *
+ * @param[in] id The identifier of the event, one of the LLKERNEL_FLASH_TRACE_* values.
+ * @param[in] address The address argument of the event.
+ * @param[in] size The size argument of the event.
+ */
+static void llkernel_trace_event(uint16_t id, uint32_t address, uint32_t size) {
+	LLKERNEL_flash_trace_event_t *event = &trace_events[trace_head];
+
+	event->timestamp = (uint32_t)LLKERNEL_FLASH_STATS_GET_TIME();
+	event->address = address;
+	event->size = size;
+	event->id = id;
+	event->sequence = trace_sequence;
+	trace_sequence++;
+	trace_head = (trace_head + 1u) % LLKERNEL_FLASH_TRACE_SIZE;
+	if (LLKERNEL_FLASH_TRACE_SIZE > trace_nb_events) {
+		trace_nb_events++;
+	}
+}
+#endif // LLKERNEL_FLASH_TRACE
+
+#if (1 == LLKERNEL_FLASH_CTRL_WRAPPERS)
+/**
+ * @brief Calls `flash_ctrl_page_write()` and updates the statistics and the trace.
+ */
+static uint32_t llkernel_ctrl_page_write(uint8_t *pData, uint32_t addr, uint32_t size) {
+	uint32_t start_time = (uint32_t)LLKERNEL_FLASH_STATS_GET_TIME();
+	LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_PROGRAM, addr, size);
+	uint32_t result = flash_ctrl_page_write(pData, addr, size);
+	LLKERNEL_STATS_ADD_TIME(program, start_time);
+	LLKERNEL_STATS_ADD(nb_pages_programmed, 1u);
+	LLKERNEL_STATS_ADD(nb_bytes_written, size);
+	return result;
+}
+
+/**
+ * @brief Calls `flash_ctrl_enable_memory_mapped_mode()` and updates the statistics and the trace.
+ */
+static uint32_t llkernel_ctrl_enable_memory_mapped_mode(void) {
+	uint32_t start_time = (uint32_t)LLKERNEL_FLASH_STATS_GET_TIME();
+	LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_MMAP_ENABLE, 0u, 0u);
+	uint32_t result = flash_ctrl_enable_memory_mapped_mode();
+	LLKERNEL_STATS_ADD_TIME(mmap_enable, start_time);
+	return result;
+}
+
+/**
+ * @brief Calls `flash_ctrl_disable_memory_mapped_mode()` and updates the statistics and the trace.
+ */
+static uint32_t llkernel_ctrl_disable_memory_mapped_mode(void) {
+	uint32_t start_time = (uint32_t)LLKERNEL_FLASH_STATS_GET_TIME();
+	LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_MMAP_DISABLE, 0u, 0u);
+	uint32_t result = flash_ctrl_disable_memory_mapped_mode();
+	LLKERNEL_STATS_ADD_TIME(mmap_disable, start_time);
+	return result;
+}
+
+// The erases are started with flash_ctrl_erase_async() when they can be suspended.
+#if (0 == LLKERNEL_FLASH_ERASE_YIELD) || (0 == LLKERNEL_FLASH_CTRL_ERASE_SUSPEND)
+/**
+ * @brief Calls `flash_ctrl_erase_subsector()` and updates the statistics and the trace.
+ */
+static uint32_t llkernel_ctrl_erase_subsector(uint32_t addr) {
+	uint32_t start_time = (uint32_t)LLKERNEL_FLASH_STATS_GET_TIME();
+	LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_ERASE, addr, flash_ctrl_get_subsector_size());
+	uint32_t result = flash_ctrl_erase_subsector(addr);
+	LLKERNEL_STATS_ADD_TIME(erase, start_time);
+	return result;
+}
+
+#if (1 == LLKERNEL_FLASH_CTRL_BLOCK_ERASE)
+/**
+ * @brief Calls `flash_ctrl_erase_block()` and updates the statistics and the trace.
+ */
+static uint32_t llkernel_ctrl_erase_block(uint32_t addr) {
+	uint32_t start_time = (uint32_t)LLKERNEL_FLASH_STATS_GET_TIME();
+	LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_ERASE, addr, flash_ctrl_get_block_size());
+	uint32_t result = flash_ctrl_erase_block(addr);
+	LLKERNEL_STATS_ADD_TIME(erase, start_time);
+	return result;
+}
+#endif // LLKERNEL_FLASH_CTRL_BLOCK_ERASE
+#endif // !LLKERNEL_FLASH_ERASE_YIELD || !LLKERNEL_FLASH_CTRL_ERASE_SUSPEND
+
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+/**
+ * @brief Calls `flash_ctrl_page_write_async()` and updates the statistics and the trace, only the start of the program
+ * is timed.
+ */
+static uint32_t llkernel_ctrl_page_write_async(uint8_t *pData, uint32_t addr, uint32_t size) {
+	uint32_t start_time = (uint32_t)LLKERNEL_FLASH_STATS_GET_TIME();
+	LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_PROGRAM, addr, size);
+	uint32_t result = flash_ctrl_page_write_async(pData, addr, size);
+	LLKERNEL_STATS_ADD_TIME(program, start_time);
+	LLKERNEL_STATS_ADD(nb_pages_programmed, 1u);
+	LLKERNEL_STATS_ADD(nb_bytes_written, size);
+	return result;
+}
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+
+#if (1 == LLKERNEL_FLASH_CTRL_WRITE_RANGE)
+/**
+ * @brief Calls `flash_ctrl_write_range()` and updates the statistics and the trace.
+ */
+static uint32_t llkernel_ctrl_write_range(uint8_t *pData, uint32_t addr, uint32_t size) {
+	uint32_t start_time = (uint32_t)LLKERNEL_FLASH_STATS_GET_TIME();
+	LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_PROGRAM, addr, size);
+	uint32_t result = flash_ctrl_write_range(pData, addr, size);
+	LLKERNEL_STATS_ADD_TIME(program, start_time);
+	LLKERNEL_STATS_ADD(nb_pages_programmed, (size + flash_ctrl_get_page_size() - 1u) / flash_ctrl_get_page_size());
+	LLKERNEL_STATS_ADD(nb_bytes_written, size);
+	return result;
+}
+#endif // LLKERNEL_FLASH_CTRL_WRITE_RANGE
+#endif // LLKERNEL_FLASH_CTRL_WRAPPERS
+
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+/**
+ * @brief Gets the device of the flash controller functions, the first device until another one is selected.
+ *
+ * @retval The selected device.
+ */
+static const flash_ctrl_device_t *llkernel_get_device(void) {
+	if (NULL == llkernel_device) {
+		llkernel_device = &flash_ctrl_get_devices()[0];
+	}
+	return llkernel_device;
+}
 
 /**
- * @brief  Checks if the feature in the slot is used.
- * @retval true if used, false otherwise.
+ * @brief Selects the device of the flash controller functions. The data buffered for the previous device are
+ * programmed first, so that the pending operations always target the selected device.
+ *
+ * @param[in] index The index of the device in the `flash_ctrl_get_devices()` array.
+ */
+static void llkernel_device_select(uint32_t index) {
+	const flash_ctrl_device_t *device = &flash_ctrl_get_devices()[index];
+
+	if (llkernel_get_device() != device) {
+		UNUSED_RETURN(LLKERNEL_IMPL_flushCopyToROM());
+		llkernel_device = device;
+	}
+}
+
+/**
+ * @brief Selects the device whose KF area contains an address, see `llkernel_device_select()`. The selection is kept
+ * if the address is outside of the KF areas.
+ *
+ * @param[in] address A flash address.
  */
-static inline bool is_feature_used(uint32_t feature_status) {
-	return (LLKERNEL_FEATURE_USED_MAGIC_NUMBER == feature_status);
+static void llkernel_device_select_address(uint32_t address) {
+	uint32_t index = llkernel_device_find(address);
+
+	if (LLKERNEL_FLASH_NB_DEVICES > index) {
+		llkernel_device_select(index);
+	}
 }
+#endif // LLKERNEL_FLASH_NB_DEVICES
 
 /**
- * @brief  Checks if the feature in the slot has been removed.
- * @retval true if removed, false otherwise.
+ * @brief Retrieves the device whose KF area contains an address.
+ *
+ * @param[in] address A flash address.
+ *
+ * @retval The index of the device, LLKERNEL_FLASH_NB_DEVICES if the address is outside of the KF areas. Always 0 with
+ * a single device.
  */
-static inline bool is_feature_removed(uint32_t feature_status) {
-	return (LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER == feature_status);
+static uint32_t llkernel_device_find(uint32_t address) {
+	uint32_t result = 0;
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+	const flash_ctrl_device_t *devices = flash_ctrl_get_devices();
+
+	result = LLKERNEL_FLASH_NB_DEVICES;
+	for (uint32_t i = 0; i < LLKERNEL_FLASH_NB_DEVICES; i++) {
+		if ((address >= devices[i].kf_start_address) && (address < devices[i].kf_end_address)) {
+			result = i;
+			break; // Leaves the loop to return the current index.
+		}
+	}
+#else
+	(void)address;
+#endif // LLKERNEL_FLASH_NB_DEVICES
+	return result;
 }
 
 /**
- * @brief  Obtains the size of the kernel feature reserved area.
+ * @brief  Obtains the size of the kernel feature reserved area, the largest one with several devices.
  * @retval kf area size
  */
 uint32_t llkernel_get_kf_area_size(void) {
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+	const flash_ctrl_device_t *devices = flash_ctrl_get_devices();
+	uint32_t result = 0;
+
+	for (uint32_t i = 0; i < LLKERNEL_FLASH_NB_DEVICES; i++) {
+		if ((devices[i].kf_end_address - devices[i].kf_start_address) > result) {
+			result = devices[i].kf_end_address - devices[i].kf_start_address;
+		}
+	}
+	return result;
+#else
 	return flash_ctrl_get_kf_end_address() - flash_ctrl_get_kf_start_address();
+#endif // LLKERNEL_FLASH_NB_DEVICES
+}
+
+/**
+ * @brief Computes the number of subsectors needed to store an amount of bytes.
+ *
+ * @param[in] size The amount of bytes to store.
+ *
+ * @retval The number of subsectors.
+ */
+static uint32_t llkernel_get_nb_subsectors(uint32_t size) {
+	uint32_t subsector_size = flash_ctrl_get_subsector_size();
+	return (size + subsector_size - 1u) / subsector_size;
+}
+
+/**
+ * @brief Computes and returns the first ram address aligned on LLKERNEL_RAM_ALIGN_SIZE bytes from an address.
+ *
+ * @param[in] address The input address where the aligned address must be found.
+ *
+ * @retval The address itself if it is aligned, the next aligned ram address otherwise.
+ */
+static uint32_t llkernel_get_aligned_ram_address(uint32_t address) {
+	uint32_t ram_address = (address + (LLKERNEL_RAM_ALIGN_SIZE - 1u)) & ~(LLKERNEL_RAM_ALIGN_SIZE - 1u);
+	return ram_address;
+}
+
+/**
+ * @brief Tells whether a page of the last created feature has not been programmed since its erase.
+ *
+ * @param[in] page_address The address of the page.
+ *
+ * @retval true if the page is known to be erased, false if its content must be read from the flash.
+ */
+static bool llkernel_is_page_erased(uint32_t page_address) {
+	return (erased_start_address <= page_address) && (erased_end_address > page_address);
+}
+
+/**
+ * @brief Records that pages are going to be programmed. The erased pages before them are not considered as erased
+ * anymore, since the pages of a feature are expected to be programmed in address order.
+ *
+ * @param[in] page_address The address of the first page.
+ * @param[in] size The size of the programmed area, a multiple of the page size.
+ */
+static void llkernel_erased_pages_consume(uint32_t page_address, uint32_t size) {
+	if ((erased_end_address > page_address) && (erased_start_address < (page_address + size))) {
+		erased_start_address = page_address + size;
+	}
+}
+
+/**
+ * @brief Checks if a feature header found at the start of a subsector describes a feature with the given status. The
+ * header must reference its own ROM area and fit in the KF area, so that the content left by a removed feature is not
+ * mistaken for a header.
+ *
+ * @param[in] feature_ptr The feature header structure pointer to check.
+ * @param[in] status The expected status, LLKERNEL_FEATURE_USED_MAGIC_NUMBER or LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER.
+ *
+ * @retval Returns true if the header is the one of a feature with the given status, false otherwise.
+ */
+static bool llkernel_is_feature_header_valid(const feature_header_t *feature_ptr, uint32_t status) {
+	uint32_t address = (uint32_t)feature_ptr;
+	uint32_t subsector_size = flash_ctrl_get_subsector_size();
+	uint32_t max_nb_subsectors = (flash_ctrl_get_kf_end_address() - address) / subsector_size;
+	bool result = false;
+
+	if ((status == feature_ptr->status) &&
+	    (feature_ptr->rom_address == (address + sizeof(feature_header_t))) &&
+	    (0u != feature_ptr->nb_subsectors) && (max_nb_subsectors >= feature_ptr->nb_subsectors)) {
+		result = (feature_ptr->rom_size <= ((feature_ptr->nb_subsectors * subsector_size) - sizeof(feature_header_t)));
+	}
+	return result;
+}
+
+#if (1 == LLKERNEL_FLASH_CRC_MOUNT_CHECK)
+/**
+ * @brief Checks the ROM area of a used feature against the CRC stored in its header. A feature without stored CRC
+ * (installed without LLKERNEL_FLASH_VERIFY_CRC or not completely copied) is considered as valid.
+ *
+ * @param[in] feature_ptr The feature header structure pointer of a used feature.
+ *
+ * @retval Returns false if the ROM area content does not match its CRC, true otherwise.
+ */
+static bool llkernel_is_feature_crc_valid(const feature_header_t *feature_ptr) {
+	bool result = true;
+
+	if (LLKERNEL_CRC32_INIT != feature_ptr->crc) {
+		uint32_t crc = 0;
+		if ((FLASH_CTRL_OK != llkernel_flash_crc(feature_ptr->rom_address, feature_ptr->rom_size, &crc)) ||
+		    (crc != feature_ptr->crc)) {
+			LLKERNEL_STATS_ADD(nb_verify_failures, 1u);
+			LLKERNEL_ERROR_LOG("%s: Feature 0x%.8x content corrupted (CRC 0x%.8x, expected 0x%.8x)\n", __func__,
+			                   (uint32_t)feature_ptr, crc, feature_ptr->crc);
+			result = false;
+		}
+	}
+	return result;
+}
+#endif // LLKERNEL_FLASH_CRC_MOUNT_CHECK
+
+/**
+ * @brief Adds a feature at the end of the feature table. The feature header must be readable.
+ *
+ * @param[in] feature_ptr The feature header structure pointer of the feature.
+ */
+static void llkernel_features_add(feature_header_t *feature_ptr) {
+	features[nb_features].header = feature_ptr;
+	features[nb_features].rom_address = feature_ptr->rom_address;
+	features[nb_features].rom_size = feature_ptr->rom_size;
+	features[nb_features].ram_address = feature_ptr->ram_address;
+	features[nb_features].ram_size = feature_ptr->ram_size;
+	nb_features++;
+}
+
+/**
+ * @brief Retrieves the allocation index of a feature from its handle.
+ *
+ * @param[in] handle The feature handle.
+ *
+ * @retval Returns the allocation index of the feature, -1 if the handle is not the one of an allocated feature.
+ */
+static int32_t llkernel_features_find(int32_t handle) {
+	int32_t result = -1;
+
+	for (uint32_t i = 0; i < nb_features; i++) {
+		if ((int32_t)features[i].header == handle) {
+			result = (int32_t)i;
+			break; // Leaves the loop to return the current index.
+		}
+	}
+	return result;
+}
+
+/**
+ * @brief Removes a feature from the feature table, the allocation index of the next features is decremented.
+ *
+ * @param[in] index The allocation index of the feature to remove.
+ */
+static void llkernel_features_remove(uint32_t index) {
+	for (uint32_t i = index + 1u; i < nb_features; i++) {
+		features[i - 1u] = features[i];
+	}
+	nb_features -= 1u;
 }
 
 /**
- * @brief Computes and returns the maximum ROM size in bytes that can be allocated per feature.
+ * @brief Retrieves the first area of kernel_ram_buffer not allocated to a feature and large enough to store an amount
+ * of bytes. The areas left by the removed features are reused.
+ *
+ * @param[in] size The amount of bytes requested.
  *
- * @retval Maximum feature ROM size in bytes.
+ * @retval Returns the start address of the area, aligned on LLKERNEL_RAM_ALIGN_SIZE, 0 if no area is large enough.
  */
-static uint32_t llkernel_get_feature_slot_size_rom_bytes(void) {
-	uint32_t nb_subsector_kf_area;
-	uint32_t nb_subsector_per_slot;
+static uint32_t llkernel_features_find_free_ram(uint32_t size) {
+	uint32_t ram_end_address = (uint32_t)&kernel_ram_buffer[0] + LLKERNEL_RAM_BUFFER_SIZE;
+	uint32_t address = llkernel_get_aligned_ram_address((uint32_t)&kernel_ram_buffer[0]);
+	bool fits = (size <= (ram_end_address - address));
+	uint32_t i = 0;
 	uint32_t result = 0;
 
-	if (0u != kernel_max_nb_dynamic_features) {
-		// Divisions done first to avoid an overflow.
-		nb_subsector_kf_area = llkernel_get_kf_area_size() / LLKERNEL_FLASH_SUBSECTOR_SIZE;
-		nb_subsector_per_slot = nb_subsector_kf_area / kernel_max_nb_dynamic_features;
-		result = nb_subsector_per_slot * LLKERNEL_FLASH_SUBSECTOR_SIZE;
+	// The candidate area is moved after each feature RAM area overlapping it, and checked again against all features.
+	while (fits && (i < nb_features)) {
+		uint32_t feature_ram_end_address = features[i].ram_address + features[i].ram_size;
+		if ((features[i].ram_address < (address + size)) && (address < feature_ram_end_address)) {
+			address = llkernel_get_aligned_ram_address(feature_ram_end_address);
+			fits = (address <= ram_end_address) && (size <= (ram_end_address - address));
+			i = 0;
+		} else {
+			i++;
+		}
+	}
+
+	if (fits) {
+		result = address;
 	}
 	return result;
 }
 
 /**
- * @brief Computes and returns the next ram address aligned on LLKERNEL_RAM_ALIGN_SIZE bits.
+ * @brief Appends an extent at the end of the extent table. A free extent following a free extent with the same erase
+ * count is merged into it, as well as any free extent following a free extent once the table is full. Used to build
+ * the extent table in address order.
  *
- * @param[in] address The input address where the next aligned address must be found.
+ * @param[in] address The start address of the extent.
+ * @param[in] nb_subsectors The number of subsectors of the extent.
+ * @param[in] used true if the extent is allocated to a feature, false if it is free.
+ * @param[in] erase_count The erase count of the extent.
  *
- * @retval The next aligned ram address.
+ * @retval Returns true on success, false if the extent table is full.
  */
-static uint32_t llkernel_get_next_aligned_ram_address(uint32_t address) {
-	uint32_t ram_address = (address & ~(LLKERNEL_RAM_ALIGN_SIZE - 1u)) + LLKERNEL_RAM_ALIGN_SIZE;
-	return ram_address;
+static bool llkernel_extents_append(uint32_t address, uint32_t nb_subsectors, bool used, uint32_t erase_count) {
+	bool result = true;
+
+	if (LLKERNEL_MAX_NB_EXTENTS <= kf_nb_extents) {
+		llkernel_extents_compact();
+	}
+
+	if ((0u != kf_nb_extents) && (!used) && (!kf_extents[kf_nb_extents - 1u].used) &&
+	    llkernel_extents_is_on_device(kf_nb_extents - 1u) &&
+	    ((erase_count == kf_extents[kf_nb_extents - 1u].erase_count) || (LLKERNEL_MAX_NB_EXTENTS <= kf_nb_extents))) {
+		kf_extents[kf_nb_extents - 1u].nb_subsectors += nb_subsectors;
+		if (erase_count > kf_extents[kf_nb_extents - 1u].erase_count) {
+			kf_extents[kf_nb_extents - 1u].erase_count = erase_count;
+		}
+	} else if (LLKERNEL_MAX_NB_EXTENTS > kf_nb_extents) {
+		kf_extents[kf_nb_extents].address = address;
+		kf_extents[kf_nb_extents].nb_subsectors = nb_subsectors;
+		kf_extents[kf_nb_extents].erase_count = erase_count;
+		kf_extents[kf_nb_extents].used = used;
+		kf_nb_extents++;
+	} else {
+		result = false;
+	}
+	return result;
+}
+
+/**
+ * @brief Removes an entry from the extent table.
+ *
+ * @param[in] index The index of the entry to remove.
+ */
+static void llkernel_extents_remove(uint32_t index) {
+	for (uint32_t i = index + 1u; i < kf_nb_extents; i++) {
+		kf_extents[i - 1u] = kf_extents[i];
+	}
+	kf_nb_extents--;
+}
+
+/**
+ * @brief Merges the adjacent free extents of the extent table, the erase count of a merged extent is the highest one.
+ * Used when the extent table is full, the extents allocated to features are then separated by one free extent at
+ * most.
+ */
+static void llkernel_extents_compact(void) {
+	uint32_t i = 1u;
+
+	while (i < kf_nb_extents) {
+		if ((!kf_extents[i - 1u].used) && (!kf_extents[i].used) &&
+		    (llkernel_device_find(kf_extents[i - 1u].address) == llkernel_device_find(kf_extents[i].address))) {
+			kf_extents[i - 1u].nb_subsectors += kf_extents[i].nb_subsectors;
+			if (kf_extents[i].erase_count > kf_extents[i - 1u].erase_count) {
+				kf_extents[i - 1u].erase_count = kf_extents[i].erase_count;
+			}
+			llkernel_extents_remove(i);
+		} else {
+			i++;
+		}
+	}
+}
+
+/**
+ * @brief Computes the size of an extent with the subsector size of its device.
+ *
+ * @param[in] index The index of the extent.
+ *
+ * @retval The size of the extent in bytes.
+ */
+static uint32_t llkernel_extents_get_size(uint32_t index) {
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+	uint32_t subsector_size = flash_ctrl_get_devices()[llkernel_device_find(kf_extents[index].address)].subsector_size;
+#else
+	uint32_t subsector_size = flash_ctrl_get_subsector_size();
+#endif // LLKERNEL_FLASH_NB_DEVICES
+	return kf_extents[index].nb_subsectors * subsector_size;
+}
+
+/**
+ * @brief Checks if an extent is in the KF area of the selected device. The extents of different devices are never
+ * merged.
+ *
+ * @param[in] index The index of the extent.
+ *
+ * @retval true if the extent is in the KF area of the selected device, always true with a single device.
+ */
+static bool llkernel_extents_is_on_device(uint32_t index) {
+	return (kf_extents[index].address >= flash_ctrl_get_kf_start_address()) &&
+	       (kf_extents[index].address < flash_ctrl_get_kf_end_address());
 }
 
 /**
- * @brief Checks if the feature targeted by feature_ptr is in the last feature slot.
+ * @brief Retrieves the extent which contains an address.
  *
- * @param[in] feature_ptr The feature header structure pointer of the target feature.
+ * @param[in] address An address of the KF area.
  *
- * @retval Returns true if the feature targeted by feature_ptr is in the last feature slot, false otherwise.
+ * @retval Returns the index of the extent, -1 if the address is outside of the KF area.
  */
-static int llkernel_feature_is_in_last_kf_slot(feature_header_t *feature_ptr) {
-	return (((uint32_t)feature_ptr + llkernel_get_feature_slot_size_rom_bytes()) >= flash_ctrl_get_kf_end_address());
+static int32_t llkernel_extents_find(uint32_t address) {
+	int32_t result = -1;
+
+	for (uint32_t i = 0; i < kf_nb_extents; i++) {
+		if ((address >= kf_extents[i].address) && ((address - kf_extents[i].address) < llkernel_extents_get_size(i))) {
+			result = (int32_t)i;
+			break; // Leaves the loop to return the current index.
+		}
+	}
+	return result;
 }
 
 /**
- * @brief Retrieves the structure pointer of the next feature.
+ * @brief Retrieves a run of adjacent free extents large enough to store an amount of subsectors. The first run found
+ * is returned, or the least erased one when LLKERNEL_FLASH_WEAR_LEVELING is enabled.
  *
- * @param[in] feature_ptr Pointer to the current feature.
+ * @param[in] nb_subsectors The number of subsectors requested.
  *
- * @retval Returns the address of the next feature header structure, NULL if the current feature is in the last
- * feature slot.
+ * @retval Returns the index of the first free extent of the run, -1 if no run is large enough.
  */
-static feature_header_t * llkernel_get_next_feature(feature_header_t *feature_ptr) {
-	feature_header_t *retval = NULL;
-	uint32_t feature_slot_size_bytes = llkernel_get_feature_slot_size_rom_bytes();
+static int32_t llkernel_extents_find_free(uint32_t nb_subsectors) {
+	int32_t result = -1;
+	uint32_t result_erase_count = 0;
+
+	for (uint32_t i = 0; i < kf_nb_extents; i++) {
+		uint32_t run_nb_subsectors = 0;
+		uint32_t run_erase_count = 0;
+		uint32_t j = i;
+
+		while ((j < kf_nb_extents) && (!kf_extents[j].used) && llkernel_extents_is_on_device(j) &&
+		       (run_nb_subsectors < nb_subsectors)) {
+			run_nb_subsectors += kf_extents[j].nb_subsectors;
+			if (kf_extents[j].erase_count > run_erase_count) {
+				run_erase_count = kf_extents[j].erase_count;
+			}
+			j++;
+		}
 
-	if (0u != feature_slot_size_bytes) {
-		if (!llkernel_feature_is_in_last_kf_slot(feature_ptr)) {
-			retval = (feature_header_t *)(((uint32_t)feature_ptr) + feature_slot_size_bytes);
+		if ((run_nb_subsectors >= nb_subsectors) && ((0 > result) || (run_erase_count < result_erase_count))) {
+			result = (int32_t)i;
+			result_erase_count = run_erase_count;
+#if (0 == LLKERNEL_FLASH_WEAR_LEVELING)
+			break; // Leaves the loop to return the first run found.
+#endif // LLKERNEL_FLASH_WEAR_LEVELING
 		}
 	}
-	return retval;
+	return result;
 }
 
 /**
- * @brief Gives the pointer to the next free feature slot.
+ * @brief Allocates the first subsectors of a run of adjacent free extents. The free extents of the run are merged into
+ * the allocated extent, with the highest erase count of the run. The remaining subsectors stay in a free extent.
  *
- * @retval A feature header structure pointer that points to the first unused feature slot.
+ * @param[in] index The index of the first free extent of the run.
+ * @param[in] nb_subsectors The number of subsectors to allocate.
+ *
+ * @retval Returns the start address of the allocated extent, 0 if the extent table is full.
  */
-static feature_header_t * llkernel_get_free_feature_slot(void) {
-	feature_header_t *feature_ptr = (feature_header_t *)flash_ctrl_get_kf_start_address();
+static uint32_t llkernel_extents_reserve(uint32_t index, uint32_t nb_subsectors) {
+	uint32_t result = 0;
+	kf_extent_t *extent = &kf_extents[index];
+	uint32_t remaining_erase_count = extent->erase_count;
+
+	while (extent->nb_subsectors < nb_subsectors) {
+		// The next extent of the run is merged, its unused subsectors keep its erase count.
+		kf_extent_t *next_extent = &kf_extents[index + 1u];
+		extent->nb_subsectors += next_extent->nb_subsectors;
+		remaining_erase_count = next_extent->erase_count;
+		if (remaining_erase_count > extent->erase_count) {
+			extent->erase_count = remaining_erase_count;
+		}
+		llkernel_extents_remove(index + 1u);
+	}
 
-	do {
-		// return first unused feature slot
-		if (!is_feature_used(feature_ptr->status)) {
-			break; // Leaves the loop to return the current feature_ptr.
+	if (extent->nb_subsectors == nb_subsectors) {
+		result = extent->address;
+	} else if (LLKERNEL_MAX_NB_EXTENTS > kf_nb_extents) {
+		// Split the free extent, the remaining subsectors are inserted after the allocated extent.
+		for (uint32_t i = kf_nb_extents; i > (index + 1u); i--) {
+			kf_extents[i] = kf_extents[i - 1u];
 		}
+		kf_extents[index + 1u].address = extent->address + (nb_subsectors * flash_ctrl_get_subsector_size());
+		kf_extents[index + 1u].nb_subsectors = extent->nb_subsectors - nb_subsectors;
+		kf_extents[index + 1u].erase_count = remaining_erase_count;
+		kf_extents[index + 1u].used = false;
+		kf_nb_extents++;
+		extent->nb_subsectors = nb_subsectors;
+		result = extent->address;
+	} else {
+		// Nothing to do, the extent table is full.
+	}
+
+	if (0u != result) {
+		extent->used = true;
+	}
+	return result;
+}
 
-		feature_ptr = llkernel_get_next_feature(feature_ptr);
-	} while (NULL != feature_ptr);
-	return feature_ptr;
+/**
+ * @brief Frees the extent allocated at an address, and coalesces it with the adjacent free extents with the same erase
+ * count. The free extents with different erase counts are kept apart to place the next features on the least erased
+ * subsectors.
+ *
+ * @param[in] address The start address of the extent.
+ */
+static void llkernel_extents_release(uint32_t address) {
+	llkernel_device_select_address(address);
+	int32_t index = llkernel_extents_find(address);
+
+	if ((0 <= index) && (kf_extents[index].address == address)) {
+		uint32_t i = (uint32_t)index;
+		uint32_t erase_count = kf_extents[i].erase_count;
+		kf_extents[i].used = false;
+		if (((i + 1u) < kf_nb_extents) && (!kf_extents[i + 1u].used) &&
+		    (erase_count == kf_extents[i + 1u].erase_count) && llkernel_extents_is_on_device(i + 1u)) {
+			kf_extents[i].nb_subsectors += kf_extents[i + 1u].nb_subsectors;
+			llkernel_extents_remove(i + 1u);
+		}
+		if ((0u < i) && (!kf_extents[i - 1u].used) && (erase_count == kf_extents[i - 1u].erase_count) &&
+		    llkernel_extents_is_on_device(i - 1u)) {
+			kf_extents[i - 1u].nb_subsectors += kf_extents[i].nb_subsectors;
+			llkernel_extents_remove(i);
+		}
+	}
 }
 
 /**
@@ -231,40 +1167,1464 @@ static const char *llkernel_error_code_to_str(uint32_t error_code) {
 	return str;
 }
 
+#if (1 == LLKERNEL_FLASH_IS_BLANK_NEEDED)
+/**
+ * @brief Checks if a flash area is erased. The memory mapped mode must be enabled.
+ *
+ * @param[in] flash_start_address The start address of the area, aligned on a subsector.
+ * @param[in] size The size of the area in bytes, multiple of the subsector size.
+ *
+ * @retval Returns true if all the bytes of the area are erased, false otherwise.
+ */
+static bool llkernel_is_flash_blank(uint32_t flash_start_address, uint32_t size) {
+	bool result = true;
+#if (1 == LLKERNEL_FLASH_CTRL_BLANK_CHECK)
+	result = (FLASH_CTRL_OK == flash_ctrl_blank_check(flash_start_address, size));
+#else
+	const uint32_t *ptr = (const uint32_t *)flash_start_address;
+	uint32_t nb_words = size / sizeof(uint32_t);
+	for (uint32_t i = 0; i < nb_words; i++) {
+		if (0xFFFFFFFFu != ptr[i]) {
+			result = false;
+			break; // Leaves the loop at the first programmed word.
+		}
+	}
+#endif // LLKERNEL_FLASH_CTRL_BLANK_CHECK
+	return result;
+}
+#endif // LLKERNEL_FLASH_IS_BLANK_NEEDED
+
+#if (1 == LLKERNEL_FLASH_SCRUB)
+/**
+ * @brief Checks if all the subsectors of a flash area are known to be erased by `LLKERNEL_flash_scrub_step()`.
+ *
+ * @param[in] flash_start_address The start address of the area, aligned on a subsector.
+ * @param[in] size The size of the area in bytes, multiple of the subsector size.
+ *
+ * @retval Returns true if all the subsectors are scrubbed, false otherwise.
+ */
+static bool llkernel_scrub_is_erased(uint32_t flash_start_address, uint32_t size) {
+	uint32_t subsector_size = flash_ctrl_get_subsector_size();
+	uint32_t first = (flash_start_address - flash_ctrl_get_kf_start_address()) / subsector_size;
+	uint32_t last = first + (size / subsector_size);
+	bool result = (last <= LLKERNEL_SCRUB_NB_SUBSECTORS);
+
+	for (uint32_t i = first; result && (i < last); i++) {
+		result = (0u != (kf_scrubbed[i / 32u] & (1uL << (i % 32u))));
+	}
+	return result;
+}
+
+/**
+ * @brief Sets or clears the scrubbed state of the subsectors of a flash area.
+ *
+ * @param[in] flash_start_address The start address of the area, aligned on a subsector.
+ * @param[in] size The size of the area in bytes, multiple of the subsector size.
+ * @param[in] is_erased true if the subsectors are erased, false if they are going to be programmed.
+ */
+static void llkernel_scrub_set(uint32_t flash_start_address, uint32_t size, bool is_erased) {
+	uint32_t subsector_size = flash_ctrl_get_subsector_size();
+	uint32_t first = (flash_start_address - flash_ctrl_get_kf_start_address()) / subsector_size;
+	uint32_t last = first + (size / subsector_size);
+
+	for (uint32_t i = first; (i < last) && (i < LLKERNEL_SCRUB_NB_SUBSECTORS); i++) {
+		if (is_erased) {
+			kf_scrubbed[i / 32u] |= (1uL << (i % 32u));
+		} else {
+			kf_scrubbed[i / 32u] &= ~(1uL << (i % 32u));
+		}
+	}
+}
+
+/**
+ * @brief Retrieves the first subsector of a free extent which is not known to be erased.
+ *
+ * @retval Returns the address of the subsector, 0 if all the free subsectors are scrubbed.
+ */
+static uint32_t llkernel_scrub_find_next(void) {
+	uint32_t subsector_size = flash_ctrl_get_subsector_size();
+	uint32_t result = 0;
+
+	for (uint32_t i = 0; (0u == result) && (i < kf_nb_extents); i++) {
+		if (!kf_extents[i].used) {
+			for (uint32_t j = 0; j < kf_extents[i].nb_subsectors; j++) {
+				uint32_t address = kf_extents[i].address + (j * subsector_size);
+				uint32_t index = (address - flash_ctrl_get_kf_start_address()) / subsector_size;
+				if (LLKERNEL_SCRUB_NB_SUBSECTORS <= index) {
+					break; // Leaves the loop, the next subsectors are not tracked.
+				}
+				if (!llkernel_scrub_is_erased(address, subsector_size)) {
+					result = address;
+					break; // Leaves the loop to return the subsector address.
+				}
+			}
+		}
+	}
+	return result;
+}
+#endif // LLKERNEL_FLASH_SCRUB
+
 /**
- * @brief Writes into the flash an amount of data. This function is to use when the amount of data to write is higher
- * than the size of a page.
+ * @brief Erases one subsector or one block. When LLKERNEL_FLASH_ERASE_YIELD and LLKERNEL_FLASH_CTRL_ERASE_SUSPEND are
+ * enabled, the erase is suspended each LLKERNEL_FLASH_ERASE_BUDGET_TIME to call LLKERNEL_FLASH_ERASE_YIELD_HOOK() with
+ * the memory mapped mode enabled. The memory mapped mode must be disabled when calling this function, and is disabled
+ * when it returns.
  *
- * @param[in] input_buffer Pointer to the data to write into the flash.
- * @param[in] flash_start_address The start address of the target flash area.
- * @param[in] size The amount of bytes to write into the flash.
+ * @param[in] flash_address The address of the subsector or of the block.
+ * @param[in] size The size of the erase unit, the subsector size or the block size.
  *
  * @retval FLASH_CTRL_OK on success, FLASH_CTRL_ERROR when the flash memory device returned an error.
  */
-static uint32_t llkernel_flash_write(uint8_t *input_buffer, uint32_t flash_start_address, uint32_t size) {
-	uint32_t remaining = size;
-	uint8_t *input_buffer_ptr = input_buffer;
-	uint32_t current_flash_address = flash_start_address;
-	uint32_t result = FLASH_CTRL_OK;
-	while (0u < remaining) {
-		uint32_t copy_size = flash_ctrl_get_page_size();
-		if (copy_size > remaining) {
-			copy_size = remaining;
-		}
-		if (FLASH_CTRL_OK != flash_ctrl_page_write((uint8_t *)input_buffer_ptr, current_flash_address,
-		                                           copy_size)) {
-			LLKERNEL_ERROR_LOG("%s: Flash error during attempt to write at the address 0x%x in the flash.\n",
-			                   __func__, current_flash_address);
-			result = FLASH_CTRL_ERROR;
-			break; // Leaves the loop after an error.
-		}
-		remaining -= copy_size;
-		// cppcheck-suppress [misra-c2012-18.4]: points after the + operation.
-		// cppcheck-suppress [misra-c2012-10.3]: this is a 8 bits pointer that stores a 32 bits address.
-		input_buffer_ptr += copy_size;
-		current_flash_address += copy_size;
+static uint32_t llkernel_erase_unit(uint32_t flash_address, uint32_t size) {
+	uint32_t result;
+#if (1 == LLKERNEL_FLASH_ERASE_YIELD) && (1 == LLKERNEL_FLASH_CTRL_ERASE_SUSPEND)
+#if (1 == LLKERNEL_FLASH_STATS)
+	uint32_t start_time = (uint32_t)LLKERNEL_FLASH_STATS_GET_TIME();
+#endif // LLKERNEL_FLASH_STATS
+	uint32_t resume_time = (uint32_t)LLKERNEL_FLASH_STATS_GET_TIME();
+	LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_ERASE, flash_address, size);
+	result = flash_ctrl_erase_async(flash_address, size);
+	bool is_busy = (FLASH_CTRL_OK == result);
+	while (is_busy) {
+		result = flash_ctrl_get_operation_status();
+		is_busy = (FLASH_CTRL_BUSY == result);
+		if (is_busy
+		    && (((uint32_t)LLKERNEL_FLASH_STATS_GET_TIME() - resume_time) >= LLKERNEL_FLASH_ERASE_BUDGET_TIME)) {
+			// The erase is suspended to let the other tasks execute from the flash.
+			result = flash_ctrl_erase_suspend();
+			if (FLASH_CTRL_OK == result) {
+				UNUSED_RETURN(llkernel_ctrl_enable_memory_mapped_mode());
+				LLKERNEL_FLASH_ERASE_YIELD_HOOK();
+				UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+				result = flash_ctrl_erase_resume();
+			}
+			is_busy = (FLASH_CTRL_OK == result);
+			resume_time = (uint32_t)LLKERNEL_FLASH_STATS_GET_TIME();
+		}
+	}
+#if (1 == LLKERNEL_FLASH_STATS)
+	// The erase time includes the suspensions.
+	llkernel_stats_add_time(&llkernel_stats.erase, start_time);
+#endif // LLKERNEL_FLASH_STATS
+#else
+#if (1 == LLKERNEL_FLASH_CTRL_BLOCK_ERASE)
+	if (flash_ctrl_get_subsector_size() != size) {
+		result = llkernel_ctrl_erase_block(flash_address);
+	} else
+#endif // LLKERNEL_FLASH_CTRL_BLOCK_ERASE
+	{
+		(void)size;
+		result = llkernel_ctrl_erase_subsector(flash_address);
+	}
+#endif // LLKERNEL_FLASH_ERASE_YIELD && LLKERNEL_FLASH_CTRL_ERASE_SUSPEND
+	return result;
+}
+
+/**
+ * @brief Gives the largest erase unit that can be used at an address. A block is used when
+ * LLKERNEL_FLASH_CTRL_BLOCK_ERASE is enabled, the address is aligned on a block and the whole block must be erased.
+ * When LLKERNEL_FLASH_ERASE_YIELD is enabled and the erase cannot be suspended, the block must also fit in
+ * LLKERNEL_FLASH_ERASE_BUDGET_SIZE.
+ *
+ * @param[in] flash_address The address of the next area to erase, aligned on a subsector.
+ * @param[in] remaining The amount of bytes remaining to erase from flash_address.
+ *
+ * @retval The size in bytes of the erase unit, either the block size or the subsector size.
+ */
+static uint32_t llkernel_get_erase_unit_size(uint32_t flash_address, uint32_t remaining) {
+	uint32_t result = flash_ctrl_get_subsector_size();
+#if (1 == LLKERNEL_FLASH_CTRL_BLOCK_ERASE)
+	uint32_t block_size = flash_ctrl_get_block_size();
+	bool is_block_allowed = (block_size <= remaining);
+#if (1 == LLKERNEL_FLASH_ERASE_YIELD) && (0 == LLKERNEL_FLASH_CTRL_ERASE_SUSPEND)
+	is_block_allowed = is_block_allowed && (block_size <= LLKERNEL_FLASH_ERASE_BUDGET_SIZE);
+#endif // LLKERNEL_FLASH_ERASE_YIELD && !LLKERNEL_FLASH_CTRL_ERASE_SUSPEND
+	if ((result < block_size) && (0u == (flash_address % block_size)) && is_block_allowed) {
+		result = block_size;
+	}
+#else
+	(void)flash_address;
+	(void)remaining;
+#endif // LLKERNEL_FLASH_CTRL_BLOCK_ERASE
+	return result;
+}
+
+/**
+ * @brief Erases consecutive subsectors, using the largest aligned erase units available. When
+ * LLKERNEL_FLASH_BLANK_CHECK is enabled, the erase units already erased are skipped. When LLKERNEL_FLASH_SCRUB is
+ * enabled, the erase units already scrubbed are skipped, and are not considered as scrubbed anymore. When
+ * LLKERNEL_FLASH_ERASE_YIELD is enabled, LLKERNEL_FLASH_ERASE_YIELD_HOOK() is called with the memory mapped mode
+ * enabled each time LLKERNEL_FLASH_ERASE_BUDGET_SIZE bytes have been erased. The memory mapped mode must be enabled
+ * when calling this function, and is enabled when it returns.
+ *
+ * @param[in] flash_start_address The start address of the first subsector.
+ * @param[in] nb_subsectors The number of subsectors to erase.
+ *
+ * @retval FLASH_CTRL_OK on success, FLASH_CTRL_ERROR when the flash memory device returned an error.
+ */
+static uint32_t llkernel_flash_erase(uint32_t flash_start_address, uint32_t nb_subsectors) {
+	uint32_t current_flash_address = flash_start_address;
+	uint32_t remaining = nb_subsectors * flash_ctrl_get_subsector_size();
+	uint32_t result = FLASH_CTRL_OK;
+	bool is_memory_mapped = true;
+#if (1 == LLKERNEL_FLASH_ERASE_YIELD)
+	// Amount of bytes erased since the last call of the yield hook.
+	uint32_t erased_size = 0u;
+#endif // LLKERNEL_FLASH_ERASE_YIELD
+
+	while (0u < remaining) {
+		uint32_t erase_size = llkernel_get_erase_unit_size(current_flash_address, remaining);
+		bool is_erase_needed = true;
+#if (1 == LLKERNEL_FLASH_SCRUB)
+		is_erase_needed = !llkernel_scrub_is_erased(current_flash_address, erase_size);
+		// The erased subsectors are going to be programmed.
+		llkernel_scrub_set(current_flash_address, erase_size, false);
+#endif // LLKERNEL_FLASH_SCRUB
+#if (1 == LLKERNEL_FLASH_BLANK_CHECK)
+		if (is_erase_needed) {
+			if (!is_memory_mapped) {
+				UNUSED_RETURN(llkernel_ctrl_enable_memory_mapped_mode());
+				is_memory_mapped = true;
+			}
+			is_erase_needed = !llkernel_is_flash_blank(current_flash_address, erase_size);
+		}
+#endif // LLKERNEL_FLASH_BLANK_CHECK
+		if (is_erase_needed) {
+#if (1 == LLKERNEL_FLASH_ERASE_YIELD)
+			if ((0u != erased_size) && ((erased_size + erase_size) > LLKERNEL_FLASH_ERASE_BUDGET_SIZE)) {
+				// The erase budget is spent: the other tasks may execute from the flash before the next erase.
+				if (!is_memory_mapped) {
+					UNUSED_RETURN(llkernel_ctrl_enable_memory_mapped_mode());
+					is_memory_mapped = true;
+				}
+				LLKERNEL_FLASH_ERASE_YIELD_HOOK();
+				erased_size = 0u;
+			}
+			erased_size += erase_size;
+#endif // LLKERNEL_FLASH_ERASE_YIELD
+			if (is_memory_mapped) {
+				UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+				is_memory_mapped = false;
+			}
+			if (FLASH_CTRL_OK != llkernel_erase_unit(current_flash_address, erase_size)) {
+				LLKERNEL_ERROR_LOG("%s: flash erase 0x%.8x failed\n", __func__, current_flash_address);
+				result = FLASH_CTRL_ERROR;
+				break; // Leaves the loop after an error.
+			}
+		}
+		current_flash_address += erase_size;
+		remaining -= erase_size;
+	}
+
+	if (!is_memory_mapped) {
+		if (FLASH_CTRL_OK != llkernel_ctrl_enable_memory_mapped_mode()) {
+			LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+		}
+	}
+	return result;
+}
+
+#if (1 == LLKERNEL_FLASH_LAZY_ERASE)
+/**
+ * @brief Erases the subsectors of the last created feature that are not erased yet, up to the subsector holding the
+ * last byte of a copy. Does nothing if the copy is not in the area of this feature. The memory mapped mode must be
+ * enabled when calling this function, and is enabled when it returns.
+ *
+ * @param[in] start_address The destination address of the copy.
+ * @param[in] end_address The end address of the copy.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR when the flash memory device returned an error.
+ */
+static int32_t llkernel_lazy_erase(uint32_t start_address, uint32_t end_address) {
+	int32_t result = LLKERNEL_OK;
+
+	if ((lazy_feature_address <= start_address) && (lazy_erase_end_address > start_address) &&
+	    (lazy_erase_address < end_address)) {
+		uint32_t subsector_size = flash_ctrl_get_subsector_size();
+		uint32_t erase_end_address = flash_ctrl_get_subsector_address(end_address - 1u) + subsector_size;
+		if (erase_end_address > lazy_erase_end_address) {
+			erase_end_address = lazy_erase_end_address;
+		}
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+		// The queued pages are programmed before the erase.
+		result = llkernel_write_buffers_wait(0u);
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+		if ((LLKERNEL_OK == result) &&
+		    (FLASH_CTRL_OK != llkernel_flash_erase(lazy_erase_address,
+		                                           (erase_end_address - lazy_erase_address) / subsector_size))) {
+			result = LLKERNEL_ERROR;
+		}
+		if (LLKERNEL_OK == result) {
+			lazy_erase_address = erase_end_address;
+		}
+	}
+	return result;
+}
+
+/**
+ * @brief Erases the subsectors of the last created feature that have not been copied, so that they are left erased
+ * like the bytes skipped by `LLKERNEL_IMPL_copyToROM()`. The memory mapped mode must be enabled when calling this
+ * function, and is enabled when it returns.
+ */
+static void llkernel_lazy_erase_complete(void) {
+	if (0u != lazy_erase_end_address) {
+		llkernel_device_select_address(lazy_feature_address);
+		if (LLKERNEL_OK != llkernel_lazy_erase(lazy_erase_address, lazy_erase_end_address)) {
+			LLKERNEL_ERROR_LOG("%s: flash erase 0x%.8x failed\n", __func__, lazy_erase_address);
+		}
+		lazy_erase_end_address = 0u;
+	}
+}
+#endif // LLKERNEL_FLASH_LAZY_ERASE
+
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+/**
+ * @brief Starts the program of the oldest queued buffer. A buffer that cannot be programmed is dropped and the next
+ * one is started. The memory mapped mode must be disabled.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR if a program could not be started.
+ */
+static int32_t llkernel_write_buffers_start(void) {
+	int32_t result = LLKERNEL_OK;
+
+	while (0u < write_buffers_nb_queued) {
+		uint32_t page_address = write_buffers_page_address[write_buffers_tail];
+		if (FLASH_CTRL_OK == llkernel_ctrl_page_write_async(write_buffers[write_buffers_tail], page_address,
+		                                                 flash_ctrl_get_page_size())) {
+			break; // Leaves the loop, the program is started.
+		}
+		LLKERNEL_ERROR_LOG("%s: flash write 0x%.8x failed\n", __func__, page_address);
+		result = LLKERNEL_ERROR;
+		write_buffers_tail = (write_buffers_tail + 1u) % LLKERNEL_WRITE_BUFFER_COUNT;
+		write_buffers_nb_queued--;
+	}
+	return result;
+}
+
+/**
+ * @brief Handles the end of the programs of the queued buffers: the content of each programmed page is checked
+ * against its buffer, and the program of the next queued buffer is started. The memory mapped mode is enabled when
+ * this function returns with no buffer queued, and disabled otherwise.
+ *
+ * @param[in] max_nb_queued The function waits until the number of queued buffers is lower than or equal to this
+ * value. Programs already done are handled without waiting.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR if a program failed.
+ */
+static int32_t llkernel_write_buffers_wait(uint32_t max_nb_queued) {
+	int32_t result = LLKERNEL_OK;
+
+	while (0u < write_buffers_nb_queued) {
+		uint32_t status = flash_ctrl_get_operation_status();
+		if (FLASH_CTRL_BUSY == status) {
+			if (write_buffers_nb_queued <= max_nb_queued) {
+				break; // Leaves the loop, no need to wait for the end of the program.
+			}
+		} else {
+			uint32_t index = write_buffers_tail;
+			uint32_t page_address = write_buffers_page_address[index];
+			bool is_memory_mapped = false;
+			write_buffers_tail = (write_buffers_tail + 1u) % LLKERNEL_WRITE_BUFFER_COUNT;
+			write_buffers_nb_queued--;
+
+			if (FLASH_CTRL_OK != status) {
+				LLKERNEL_ERROR_LOG("%s: flash write 0x%.8x failed (status=%d)\n", __func__, page_address, status);
+				result = LLKERNEL_ERROR;
+			}
+#if (LLKERNEL_FLASH_VERIFY_PAGE == LLKERNEL_FLASH_VERIFY_MODE)
+			else {
+				UNUSED_RETURN(llkernel_ctrl_enable_memory_mapped_mode());
+				is_memory_mapped = true;
+				if (memcmp(write_buffers[index], (uint8_t *)page_address, flash_ctrl_get_page_size()) != 0) {
+					LLKERNEL_STATS_ADD(nb_verify_failures, 1u);
+					LLKERNEL_ERROR_LOG("%s: Flash write from buffer invalid\n", __func__);
+				}
+			}
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+
+			if (0u < write_buffers_nb_queued) {
+				if (is_memory_mapped) {
+					UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+				}
+				if (LLKERNEL_OK != llkernel_write_buffers_start()) {
+					result = LLKERNEL_ERROR;
+				}
+			} else if (!is_memory_mapped) {
+				if (FLASH_CTRL_OK != llkernel_ctrl_enable_memory_mapped_mode()) {
+					LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+				}
+			} else {
+				// Nothing to do, the memory mapped mode is enabled.
+			}
+		}
+	}
+	return result;
+}
+
+/**
+ * @brief Queues mem_writeBuffer to be programmed into a flash page, and gives the next buffer of the ring to
+ * mem_writeBuffer. The program is started at once when no other buffer is being programmed. The memory mapped mode
+ * must be disabled.
+ *
+ * @param[in] page_address The start address of the destination page.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR if the program could not be started.
+ */
+static int32_t llkernel_write_buffers_submit(uint32_t page_address) {
+	int32_t result = LLKERNEL_OK;
+
+	write_buffers_page_address[write_buffers_head] = page_address;
+	write_buffers_nb_queued++;
+	if (1u == write_buffers_nb_queued) {
+		result = llkernel_write_buffers_start();
+	}
+	write_buffers_head = (write_buffers_head + 1u) % LLKERNEL_WRITE_BUFFER_COUNT;
+	mem_writeBuffer = write_buffers[write_buffers_head];
+	return result;
+}
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+
+/**
+ * @brief Waits for the end of the page programs started asynchronously from the write buffers. Does nothing when
+ * LLKERNEL_FLASH_CTRL_ASYNC is disabled. The memory mapped mode is enabled when this function returns.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR if a pending program failed.
+ */
+static int32_t llkernel_flash_sync(void) {
+	int32_t result = LLKERNEL_OK;
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+	result = llkernel_write_buffers_wait(0u);
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+	return result;
+}
+
+#if (1 == LLKERNEL_FLASH_CTRL_WRITE_RANGE)
+/**
+ * @brief Writes several whole pages of a `LLKERNEL_IMPL_copyToROM()` call at once with `flash_ctrl_write_range()`,
+ * directly from the source data. The memory mapped mode must be disabled when calling this function, and is disabled
+ * when it returns.
+ *
+ * @param[in] src_ptr The source data.
+ * @param[in] flash_start_address The destination address, aligned on a page.
+ * @param[in] size The amount of bytes to write, a multiple of the page size.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR if an error occurs.
+ */
+static int32_t llkernel_flash_write_range(const uint8_t *src_ptr, uint32_t flash_start_address, uint32_t size) {
+	// The pages queued before must be programmed first.
+	int32_t result = llkernel_flash_sync();
+
+	if (LLKERNEL_OK == result) {
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+		// The memory mapped mode is enabled once the queued buffers are programmed.
+		UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+		LLKERNEL_DEBUG_LOG("%s: range write (addr: 0x%.8x, len: 0x%.8x)\n", __func__, flash_start_address, size);
+		if (FLASH_CTRL_OK != llkernel_ctrl_write_range((uint8_t *)src_ptr, flash_start_address, size)) {
+			LLKERNEL_ERROR_LOG("%s: flash write 0x%.8x failed\n", __func__, flash_start_address);
+			result = LLKERNEL_ERROR;
+		}
+	}
+#if (LLKERNEL_FLASH_VERIFY_PAGE == LLKERNEL_FLASH_VERIFY_MODE)
+	if (LLKERNEL_OK == result) {
+		UNUSED_RETURN(llkernel_ctrl_enable_memory_mapped_mode());
+		if (memcmp((uint8_t *)flash_start_address, src_ptr, size) != 0) {
+			LLKERNEL_STATS_ADD(nb_verify_failures, 1u);
+			LLKERNEL_ERROR_LOG("%s: Flash write invalid\n", __func__);
+		}
+		UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+	}
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+	return result;
+}
+#endif // LLKERNEL_FLASH_CTRL_WRITE_RANGE
+
+/**
+ * @brief Programs the page assembled in mem_writeBuffer, the end of the page is left erased. Does nothing if no page
+ * is buffered. The memory mapped mode is enabled when this function returns.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR if an error occurs.
+ */
+static int32_t llkernel_write_buffer_flush(void) {
+	int32_t result = llkernel_flash_sync();
+
+	if (target_page_address != NULL) {
+		// The end of the page is left erased.
+		// cppcheck-suppress [misra-c2012-18.4]: points after the + operation.
+		UNUSED_RETURN(memset((void *)(mem_writeBuffer + mem_writeBuffer_offset), 0xFF,
+		                     flash_ctrl_get_page_size() - mem_writeBuffer_offset));
+		UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+		uint32_t status = llkernel_copy_page_write((uint8_t *)mem_writeBuffer, (uint32_t)target_page_address,
+		                                           mem_writeBuffer_start, mem_writeBuffer_offset);
+		UNUSED_RETURN(llkernel_ctrl_enable_memory_mapped_mode());
+		if (FLASH_CTRL_OK != status) {
+			LLKERNEL_ERROR_LOG("%s: flash write 0x%.8x failed (status=%d)\n", __func__, (uint32_t)target_page_address,
+			                   status);
+			result = LLKERNEL_ERROR;
+		}
+		target_page_address = NULL;
+		mem_writeBuffer_offset = 0;
+	}
+	return result;
+}
+
+#if (1u < LLKERNEL_FLASH_NB_WRITE_CONTEXTS)
+/**
+ * @brief Swaps the page assembled in mem_writeBuffer with the page kept in a write context. Only the bytes stored in
+ * one of the two buffers are exchanged. When LLKERNEL_FLASH_CTRL_ASYNC is 1, mem_writeBuffer must not be queued.
+ *
+ * @param[in] context The write context.
+ */
+static void llkernel_write_context_swap(write_context_t *context) {
+	uint8_t *page_address = context->target_page_address;
+	uint32_t offset = context->offset;
+	uint32_t start = context->start;
+	uint32_t size = (offset > mem_writeBuffer_offset) ? offset : mem_writeBuffer_offset;
+
+	for (uint32_t i = 0; i < size; i++) {
+		uint8_t byte = context->buffer[i];
+		context->buffer[i] = mem_writeBuffer[i];
+		mem_writeBuffer[i] = byte;
+	}
+	context->target_page_address = target_page_address;
+	context->offset = mem_writeBuffer_offset;
+	context->start = mem_writeBuffer_start;
+	write_contexts_clock++;
+	context->last_use = write_contexts_clock;
+	target_page_address = page_address;
+	mem_writeBuffer_offset = offset;
+	mem_writeBuffer_start = start;
+}
+
+/**
+ * @brief Selects the page buffers for a copy into the feature of an extent. The page assembled in mem_writeBuffer for
+ * another feature is kept in a write context, and the page kept for the feature of the extent, if any, is moved to
+ * mem_writeBuffer. When all the write contexts are used, the page kept for the longest time is programmed to free its
+ * context.
+ *
+ * @param[in] extent_index The index of the extent of the feature, -1 to only empty mem_writeBuffer.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR if an error occurs.
+ */
+static int32_t llkernel_write_contexts_select(int32_t extent_index) {
+	int32_t result = LLKERNEL_OK;
+
+	if ((NULL == target_page_address) || (extent_index != llkernel_extents_find((uint32_t)target_page_address))) {
+		write_context_t *context = NULL; // context of the feature of the address, or free or oldest context
+		bool is_found = false;
+		for (uint32_t i = 0; i < (LLKERNEL_FLASH_NB_WRITE_CONTEXTS - 1u); i++) {
+			write_context_t *candidate = &write_contexts[i];
+			if (NULL == candidate->target_page_address) {
+				if ((NULL == context) || (NULL != context->target_page_address)) {
+					context = candidate;
+				}
+			} else if (extent_index == llkernel_extents_find((uint32_t)candidate->target_page_address)) {
+				context = candidate;
+				is_found = true;
+				break; // Leaves the loop, the page of the feature is found.
+			} else if ((NULL == context) ||
+			           ((NULL != context->target_page_address) && (candidate->last_use < context->last_use))) {
+				context = candidate;
+			} else {
+				// Nothing to do, a better context is already found.
+			}
+		}
+
+		if (is_found || (NULL != target_page_address)) {
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+			// mem_writeBuffer is refilled only once its previous program is done.
+			result = llkernel_write_buffers_wait(LLKERNEL_WRITE_BUFFER_COUNT - 1u);
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+			if (LLKERNEL_OK == result) {
+				llkernel_write_context_swap(context);
+				if ((!is_found) && (NULL != target_page_address)) {
+					// No free context, the page of the oldest context, now in mem_writeBuffer, is programmed.
+					result = llkernel_write_buffer_flush();
+				}
+			}
+		}
+	}
+	return result;
+}
+
+#endif // LLKERNEL_FLASH_NB_WRITE_CONTEXTS
+
+/**
+ * @brief Drops the pages assembled for a ROM area, in mem_writeBuffer or in the write contexts, without programming
+ * them.
+ *
+ * @param[in] start_address The start address of the ROM area.
+ * @param[in] end_address The end address of the ROM area.
+ */
+static void llkernel_write_buffers_discard(uint32_t start_address, uint32_t end_address) {
+	if ((start_address <= (uint32_t)target_page_address) && (end_address > (uint32_t)target_page_address)) {
+		target_page_address = NULL;
+		mem_writeBuffer_offset = 0;
+	}
+#if (1u < LLKERNEL_FLASH_NB_WRITE_CONTEXTS)
+	for (uint32_t i = 0; i < (LLKERNEL_FLASH_NB_WRITE_CONTEXTS - 1u); i++) {
+		uint32_t page_address = (uint32_t)write_contexts[i].target_page_address;
+		if ((start_address <= page_address) && (end_address > page_address)) {
+			write_contexts[i].target_page_address = NULL;
+			write_contexts[i].offset = 0;
+		}
+	}
+#endif // LLKERNEL_FLASH_NB_WRITE_CONTEXTS
+}
+
+#if (LLKERNEL_FLASH_VERIFY_DEFERRED == LLKERNEL_FLASH_VERIFY_MODE)
+/**
+ * @brief Checks the data programmed by a `LLKERNEL_IMPL_copyToROM()` call against its source. The bytes still
+ * buffered in mem_writeBuffer are not checked. The memory mapped mode must be enabled.
+ *
+ * @param[in] dest_ptr The destination address of the copy.
+ * @param[in] src_ptr The source address of the copy.
+ * @param[in] size The size of the copy in bytes.
+ *
+ * @retval LLKERNEL_OK if the programmed data match the source, LLKERNEL_ERROR otherwise.
+ */
+static int32_t llkernel_verify_copy(const uint8_t *dest_ptr, const uint8_t *src_ptr, uint32_t size) {
+	int32_t result = LLKERNEL_OK;
+	uint32_t verify_size = size;
+
+	if (NULL != target_page_address) {
+		// The last page is not programmed yet.
+		verify_size = 0u;
+		if ((uint32_t)target_page_address > (uint32_t)dest_ptr) {
+			verify_size = (uint32_t)target_page_address - (uint32_t)dest_ptr;
+		}
+	}
+	if (memcmp(dest_ptr, src_ptr, verify_size) != 0) {
+		LLKERNEL_STATS_ADD(nb_verify_failures, 1u);
+		LLKERNEL_ERROR_LOG("%s: Flash write invalid\n", __func__);
+		result = LLKERNEL_ERROR;
+	}
+	return result;
+}
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+
+/**
+ * @brief Programs the bytes of a page content between two offsets, rounded to LLKERNEL_FLASH_PROGRAM_UNIT_SIZE. The
+ * whole page is programmed when the program unit is the page size. The memory mapped mode must be disabled.
+ *
+ * @param[in] pData The page content.
+ * @param[in] page_address The start address of the destination page.
+ * @param[in] start_offset The offset in the page of the first byte to program.
+ * @param[in] end_offset The offset in the page following the last byte to program.
+ *
+ * @retval FLASH_CTRL_OK on success, FLASH_CTRL_ERROR when the flash memory device returned an error.
+ */
+static uint32_t llkernel_page_write_range(uint8_t *pData, uint32_t page_address, uint32_t start_offset,
+                                          uint32_t end_offset) {
+	uint32_t start = start_offset & ~(LLKERNEL_FLASH_PROGRAM_UNIT_SIZE - 1u);
+	uint32_t end = (end_offset + LLKERNEL_FLASH_PROGRAM_UNIT_SIZE - 1u) & ~(LLKERNEL_FLASH_PROGRAM_UNIT_SIZE - 1u);
+	if (end > flash_ctrl_get_page_size()) {
+		end = flash_ctrl_get_page_size();
+	}
+	// cppcheck-suppress [misra-c2012-18.4]: points after the + operation.
+	return llkernel_ctrl_page_write(pData + start, page_address + start, end - start);
+}
+
+/**
+ * @brief Programs a word in a page already programmed. The rest of the page is programmed again with its current
+ * content, so only bits of the word set to 1 can be cleared. No data must be buffered in mem_writeBuffer. The memory
+ * mapped mode must be enabled when calling this function, and is enabled when it returns.
+ *
+ * @param[in] address The address of the word, aligned on 4 bytes.
+ * @param[in] value The new value of the word.
+ *
+ * @retval FLASH_CTRL_OK on success, FLASH_CTRL_ERROR when the flash memory device returned an error.
+ */
+static uint32_t llkernel_flash_program_word(uint32_t address, uint32_t value) {
+	llkernel_device_select_address(address);
+	uint32_t page_address = flash_ctrl_get_page_address(address);
+	uint32_t result;
+
+	UNUSED_RETURN(memcpy((void *)mem_writeBuffer, (const void *)page_address, flash_ctrl_get_page_size()));
+	// cppcheck-suppress [misra-c2012-18.4]: points after the + operation.
+	UNUSED_RETURN(memcpy((void *)(mem_writeBuffer + (address - page_address)), (const void *)&value, sizeof(value)));
+
+	UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+	result = llkernel_page_write_range((uint8_t *)mem_writeBuffer, page_address, address - page_address,
+	                                   (address - page_address) + sizeof(value));
+	if (FLASH_CTRL_OK != llkernel_ctrl_enable_memory_mapped_mode()) {
+		LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+	}
+	if (FLASH_CTRL_OK != result) {
+		LLKERNEL_ERROR_LOG("%s: flash write 0x%.8x failed\n", __func__, address);
+	}
+	return result;
+}
+
+#if (1 == LLKERNEL_FLASH_CRC)
+/**
+ * @brief Updates a CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320) with an amount of data. The initial value is
+ * LLKERNEL_CRC32_INIT and the final value must be inverted.
+ *
+ * @param[in] crc The current CRC value.
+ * @param[in] data Pointer to the data.
+ * @param[in] size The amount of bytes of data.
+ *
+ * @retval The updated CRC value.
+ */
+static uint32_t llkernel_crc32_update(uint32_t crc, const uint8_t *data, uint32_t size) {
+	static const uint32_t crc32_table[16] = {
+		0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+		0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu, 0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu
+	};
+	uint32_t result = crc;
+
+	for (uint32_t i = 0; i < size; i++) {
+		result = (result >> 4) ^ crc32_table[(result ^ data[i]) & 0x0Fu];
+		result = (result >> 4) ^ crc32_table[(result ^ ((uint32_t)data[i] >> 4)) & 0x0Fu];
+	}
+	return result;
+}
+
+/**
+ * @brief Computes the CRC-32 of a flash area, with `flash_ctrl_crc()` when LLKERNEL_FLASH_CTRL_CRC is enabled. The
+ * memory mapped mode must be enabled.
+ *
+ * @param[in] flash_start_address The start address of the area.
+ * @param[in] size The size of the area in bytes.
+ * @param[out] crc The final CRC-32 value of the area.
+ *
+ * @retval FLASH_CTRL_OK on success, FLASH_CTRL_ERROR if an error occurs.
+ */
+static uint32_t llkernel_flash_crc(uint32_t flash_start_address, uint32_t size, uint32_t *crc) {
+#if (1 == LLKERNEL_FLASH_CTRL_CRC)
+	return flash_ctrl_crc(flash_start_address, size, crc);
+#else
+	*crc = ~llkernel_crc32_update(LLKERNEL_CRC32_INIT, (const uint8_t *)flash_start_address, size);
+	return FLASH_CTRL_OK;
+#endif // LLKERNEL_FLASH_CTRL_CRC
+}
+#endif // LLKERNEL_FLASH_CRC
+
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+/**
+ * @brief Updates the CRC of the feature being installed with the data of a `LLKERNEL_IMPL_copyToROM()` call. The
+ * bytes skipped between two calls are left erased and counted as 0xFF. The CRC is not computed anymore if the data
+ * are not copied in increasing address order.
+ *
+ * @param[in] dest_ptr The destination address of the copy.
+ * @param[in] src_ptr The source address of the copy.
+ * @param[in] size The size of the copy in bytes.
+ */
+static void llkernel_crc_stream_update(const uint8_t *dest_ptr, const uint8_t *src_ptr, uint32_t size) {
+	static const uint8_t erased_byte = 0xFFu;
+	uint32_t dest_address = (uint32_t)dest_ptr;
+
+	if ((NULL != crc_feature_ptr) && (dest_address >= (uint32_t)crc_feature_ptr) &&
+	    (dest_address < crc_end_address)) {
+		if (dest_address < crc_next_address) {
+			LLKERNEL_WARNING_LOG("%s: ROM area not copied in order, CRC not computed\n", __func__);
+			crc_feature_ptr = NULL;
+		} else {
+			while (crc_next_address < dest_address) {
+				crc_value = llkernel_crc32_update(crc_value, &erased_byte, 1u);
+				crc_next_address++;
+			}
+			crc_value = llkernel_crc32_update(crc_value, src_ptr, size);
+			crc_next_address += size;
+		}
+	}
+}
+
+/**
+ * @brief Once the whole ROM area of the feature being installed has been copied and flushed, compares the CRC of the
+ * copied data with the CRC of the flash content, and stores it in the feature header. The memory mapped mode must be
+ * enabled.
+ *
+ * @retval LLKERNEL_OK on success or if the ROM area is not complete, LLKERNEL_ERROR if the flash content is invalid.
+ */
+static int32_t llkernel_crc_stream_check(void) {
+	int32_t result = LLKERNEL_OK;
+
+	if ((NULL != crc_feature_ptr) && (crc_next_address == crc_end_address)) {
+		uint32_t rom_address = crc_feature_ptr->rom_address;
+		uint32_t flash_crc = 0;
+		if (FLASH_CTRL_OK != llkernel_flash_crc(rom_address, crc_end_address - rom_address, &flash_crc)) {
+			LLKERNEL_ERROR_LOG("%s: CRC computation of 0x%.8x failed\n", __func__, rom_address);
+			result = LLKERNEL_ERROR;
+		} else if (flash_crc != ~crc_value) {
+			LLKERNEL_STATS_ADD(nb_verify_failures, 1u);
+			LLKERNEL_ERROR_LOG("%s: Flash write invalid (CRC 0x%.8x, expected 0x%.8x)\n", __func__, flash_crc,
+			                   ~crc_value);
+			result = LLKERNEL_ERROR;
+		} else {
+			// cppcheck-suppress [misra-c2012-11.4]: address of the header field in the flash.
+			uint32_t crc_address = (uint32_t)&crc_feature_ptr->crc;
+			UNUSED_RETURN(llkernel_flash_program_word(crc_address, flash_crc));
+		}
+		crc_feature_ptr = NULL;
+	}
+	return result;
+}
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+/**
+ * @brief Gives the size of the granules by which the installation progress of a feature is recorded, the smallest
+ * multiple of the subsector size that splits the feature area in at most LLKERNEL_INSTALL_NB_GRANULES granules.
+ *
+ * @param[in] feature_ptr The feature header.
+ *
+ * @retval The size of a granule in bytes.
+ */
+static uint32_t llkernel_install_get_granule_size(const feature_header_t *feature_ptr) {
+	uint32_t nb_subsectors = (feature_ptr->nb_subsectors + LLKERNEL_INSTALL_NB_GRANULES - 1u) /
+	                         LLKERNEL_INSTALL_NB_GRANULES;
+	return nb_subsectors * flash_ctrl_get_subsector_size();
+}
+
+/**
+ * @brief Reads the installation progress recorded in a feature header.
+ *
+ * @param[in] feature_ptr The feature header.
+ *
+ * @retval The number of granules of the feature area programmed, -1 if the progress of the feature is not recorded.
+ */
+static int32_t llkernel_install_get_nb_granules(const feature_header_t *feature_ptr) {
+	int32_t result = -1;
+
+	if (0u == (feature_ptr->install_progress[0] & 1u)) {
+		result = 0;
+		for (uint32_t i = 1u; i <= LLKERNEL_INSTALL_NB_GRANULES; i++) {
+			if (0u != (feature_ptr->install_progress[i / 32u] & (1u << (i % 32u)))) {
+				break; // Leaves the loop at the first granule not programmed.
+			}
+			result++;
+		}
+	}
+	return result;
+}
+
+/**
+ * @brief Gives the amount of bytes of the ROM area of a feature covered by the first granules of its area.
+ *
+ * @param[in] feature_ptr The feature header.
+ * @param[in] nb_granules The number of granules programmed.
+ *
+ * @retval The amount of bytes from the start of the ROM area, at most the ROM area size.
+ */
+static uint32_t llkernel_install_get_progress(const feature_header_t *feature_ptr, uint32_t nb_granules) {
+	uint32_t end_address = (uint32_t)feature_ptr + (nb_granules * llkernel_install_get_granule_size(feature_ptr));
+	uint32_t result = 0u;
+
+	if (end_address > feature_ptr->rom_address) {
+		result = end_address - feature_ptr->rom_address;
+	}
+	if (result > feature_ptr->rom_size) {
+		result = feature_ptr->rom_size;
+	}
+	return result;
+}
+
+/**
+ * @brief Records in the header of the feature being installed the granules programmed up to an address, or all its
+ * granules once its whole ROM area has been copied, its progress is then not computed anymore. The header is programmed
+ * again with the bits of the new granules cleared. The memory mapped mode must be enabled when calling this function,
+ * and is enabled when it returns.
+ *
+ * @param[in] programmed_address The address up to which the ROM area is copied and not buffered anymore.
+ */
+static void llkernel_install_record(uint32_t programmed_address) {
+	uint32_t granule_size = llkernel_install_get_granule_size(install_feature_ptr);
+	uint32_t nb_granules = (programmed_address - (uint32_t)install_feature_ptr) / granule_size;
+	bool is_complete = (programmed_address >= (install_feature_ptr->rom_address + install_feature_ptr->rom_size));
+
+	if (is_complete) {
+		nb_granules = ((install_feature_ptr->nb_subsectors * flash_ctrl_get_subsector_size()) + granule_size - 1u) /
+		              granule_size;
+	}
+	// The progress is recorded on the device of the feature only, selected by the copies to the feature.
+	if ((nb_granules > install_nb_granules) &&
+	    (flash_ctrl_get_kf_start_address() <= (uint32_t)install_feature_ptr) &&
+	    (flash_ctrl_get_kf_end_address() > (uint32_t)install_feature_ptr)) {
+		feature_header_t header;
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+		// The queued pages are programmed before the progress is recorded.
+		UNUSED_RETURN(llkernel_write_buffers_wait(0u));
+		UNUSED_RETURN(llkernel_ctrl_enable_memory_mapped_mode());
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+		UNUSED_RETURN(memcpy((void *)&header, (const void *)install_feature_ptr, sizeof(header)));
+		for (uint32_t i = install_nb_granules + 1u; i <= nb_granules; i++) {
+			header.install_progress[i / 32u] &= ~(1u << (i % 32u));
+		}
+		UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+		if (FLASH_CTRL_OK != llkernel_ctrl_page_write((uint8_t *)&header, (uint32_t)install_feature_ptr,
+		                                              sizeof(header))) {
+			LLKERNEL_ERROR_LOG("%s: flash write 0x%.8x failed\n", __func__, (uint32_t)install_feature_ptr);
+		}
+		if (FLASH_CTRL_OK != llkernel_ctrl_enable_memory_mapped_mode()) {
+			LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+		}
+		install_nb_granules = nb_granules;
+	}
+	if (is_complete && (install_nb_granules == nb_granules)) {
+		// The installation is complete, its progress does not change anymore.
+		install_feature_ptr = NULL;
+	}
+}
+
+/**
+ * @brief Updates the progress of the feature being installed with a `LLKERNEL_IMPL_copyToROM()` call. The bytes
+ * skipped between two calls are left erased. The progress is not recorded anymore if the data are not copied in
+ * increasing address order.
+ *
+ * @param[in] dest_ptr The destination address of the copy.
+ * @param[in] size The size of the copy in bytes.
+ */
+static void llkernel_install_update(const uint8_t *dest_ptr, uint32_t size) {
+	uint32_t dest_address = (uint32_t)dest_ptr;
+
+	if ((NULL != install_feature_ptr) && (dest_address >= install_feature_ptr->rom_address) &&
+	    (dest_address < (install_feature_ptr->rom_address + install_feature_ptr->rom_size))) {
+		if (dest_address < install_next_address) {
+			LLKERNEL_WARNING_LOG("%s: ROM area not copied in order, progress not recorded\n", __func__);
+			install_feature_ptr = NULL;
+		} else {
+			install_next_address = dest_address + size;
+			// The buffered page is not programmed yet.
+			llkernel_install_record((NULL != target_page_address) ? (uint32_t)target_page_address :
+			                        install_next_address);
+		}
+	}
+}
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+
+#if (1 == LLKERNEL_STREAM_CONTEXTS)
+/**
+ * @brief Gives the feature of the CRC and of the installation progress being computed, both are computed for the same
+ * feature.
+ *
+ * @retval The feature header, NULL if neither the CRC nor the progress is computed.
+ */
+static feature_header_t * llkernel_stream_get_feature(void) {
+	feature_header_t *result = NULL;
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+	result = crc_feature_ptr;
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+	if (NULL == result) {
+		result = install_feature_ptr;
+	}
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+	return result;
+}
+
+/**
+ * @brief Swaps the CRC and the installation progress being computed with the copy state kept in a stream context.
+ *
+ * @param[in] context The stream context.
+ */
+static void llkernel_stream_context_swap(stream_context_t *context) {
+	stream_context_t current;
+
+	current.feature_ptr = llkernel_stream_get_feature();
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+	current.crc_feature_ptr = crc_feature_ptr;
+	current.crc_next_address = crc_next_address;
+	current.crc_end_address = crc_end_address;
+	current.crc_value = crc_value;
+	crc_feature_ptr = context->crc_feature_ptr;
+	crc_next_address = context->crc_next_address;
+	crc_end_address = context->crc_end_address;
+	crc_value = context->crc_value;
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+	current.install_feature_ptr = install_feature_ptr;
+	current.install_next_address = install_next_address;
+	current.install_nb_granules = install_nb_granules;
+	install_feature_ptr = context->install_feature_ptr;
+	install_next_address = context->install_next_address;
+	install_nb_granules = context->install_nb_granules;
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+	stream_contexts_clock++;
+	current.last_use = stream_contexts_clock;
+	*context = current;
+}
+
+/**
+ * @brief Selects the CRC and the installation progress of a feature for a copy into its ROM area. The copy state of
+ * another feature is kept in a stream context, and the copy state kept for the feature, if any, is restored. When all
+ * the stream contexts are used, the copy state kept for the longest time is dropped: the CRC of its feature is not
+ * computed and its progress is not recorded anymore.
+ *
+ * @param[in] feature_ptr The feature header.
+ */
+static void llkernel_stream_contexts_select(const feature_header_t *feature_ptr) {
+	feature_header_t *current_feature_ptr = llkernel_stream_get_feature();
+
+	if (feature_ptr != current_feature_ptr) {
+		stream_context_t *context = NULL; // context of the feature, or free or oldest context
+		bool is_found = false;
+		for (uint32_t i = 0; i < (LLKERNEL_FLASH_NB_WRITE_CONTEXTS - 1u); i++) {
+			stream_context_t *candidate = &stream_contexts[i];
+			if (NULL == candidate->feature_ptr) {
+				if ((NULL == context) || (NULL != context->feature_ptr)) {
+					context = candidate;
+				}
+			} else if (feature_ptr == candidate->feature_ptr) {
+				context = candidate;
+				is_found = true;
+				break; // Leaves the loop, the copy state of the feature is found.
+			} else if ((NULL == context) ||
+			           ((NULL != context->feature_ptr) && (candidate->last_use < context->last_use))) {
+				context = candidate;
+			} else {
+				// Nothing to do, a better context is already found.
+			}
+		}
+
+		if (is_found || (NULL != current_feature_ptr)) {
+			llkernel_stream_context_swap(context);
+			if (!is_found) {
+				// The feature has no copy state, the one of the oldest context is dropped.
+				LLKERNEL_DEBUG_LOG("%s: CRC and progress of 0x%.8x dropped\n", __func__,
+				                   (uint32_t)llkernel_stream_get_feature());
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+				crc_feature_ptr = NULL;
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+				install_feature_ptr = NULL;
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+			}
+		}
+	}
+}
+
+/**
+ * @brief Checks the CRC and records the installation progress of the features of the stream contexts, once their
+ * pages are programmed by `LLKERNEL_IMPL_flushCopyToROM()`. The memory mapped mode must be enabled.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR if the flash content of a feature is invalid.
+ */
+static int32_t llkernel_stream_contexts_complete(void) {
+	int32_t result = LLKERNEL_OK;
+
+	for (uint32_t i = 0; i < (LLKERNEL_FLASH_NB_WRITE_CONTEXTS - 1u); i++) {
+		if (NULL != stream_contexts[i].feature_ptr) {
+			llkernel_stream_context_swap(&stream_contexts[i]);
+			llkernel_device_select_address((uint32_t)llkernel_stream_get_feature());
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+			if (LLKERNEL_OK != llkernel_crc_stream_check()) {
+				result = LLKERNEL_ERROR;
+			}
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+			if (NULL != install_feature_ptr) {
+				llkernel_install_record(install_next_address);
+			}
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+			llkernel_stream_context_swap(&stream_contexts[i]);
+		}
+	}
+	return result;
+}
+
+/**
+ * @brief Drops the copy state of a feature kept in a stream context.
+ *
+ * @param[in] feature_ptr The feature header.
+ */
+static void llkernel_stream_contexts_discard(const feature_header_t *feature_ptr) {
+	for (uint32_t i = 0; i < (LLKERNEL_FLASH_NB_WRITE_CONTEXTS - 1u); i++) {
+		if (feature_ptr == stream_contexts[i].feature_ptr) {
+			stream_contexts[i].feature_ptr = NULL;
+		}
+	}
+}
+#endif // LLKERNEL_STREAM_CONTEXTS
+
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+/**
+ * @brief Checks whether a flash address is in the subsectors of the feature being updated in place.
+ *
+ * @param[in] address The flash address.
+ *
+ * @retval true if the pages written at this address are compared with the flash content, false otherwise.
+ */
+static bool llkernel_delta_is_active(uint32_t address) {
+	return (NULL != delta_feature_ptr) && ((uint32_t)delta_feature_ptr <= address) && (delta_end_address > address);
+}
+
+/**
+ * @brief Writes a page of the feature being updated in place. The page is not programmed when the flash already holds
+ * the same content. Otherwise its subsector is erased, unless it has already been erased by the update, and the
+ * unchanged pages of the subsector preceding this one are programmed back. The memory mapped mode must be disabled
+ * when calling this function, and is disabled when it returns.
+ *
+ * @param[in] pData The page content.
+ * @param[in] page_address The start address of the destination page, not lower than the address of the page written
+ * before by the update.
+ * @param[in] size The amount of bytes to write, at most the page size.
+ *
+ * @retval FLASH_CTRL_OK on success, FLASH_CTRL_ERROR when the page cannot be written.
+ */
+static uint32_t llkernel_delta_page_write(uint8_t *pData, uint32_t page_address, uint32_t size) {
+	uint32_t subsector_address = flash_ctrl_get_subsector_address(page_address);
+	uint32_t status = FLASH_CTRL_OK;
+	bool is_write_needed = true;
+
+	if (page_address < delta_page_address) {
+		// The pages after this one may already be programmed in the subsector.
+		LLKERNEL_ERROR_LOG("%s: feature not updated in address order (0x%.8x)\n", __func__, page_address);
+		status = FLASH_CTRL_ERROR;
+	} else if (subsector_address != delta_erased_address) {
+		UNUSED_RETURN(llkernel_ctrl_enable_memory_mapped_mode());
+		is_write_needed = (0 != memcmp((const void *)page_address, (const void *)pData, size));
+		if (!is_write_needed) {
+			LLKERNEL_STATS_ADD(nb_pages_skipped, 1u);
+		} else {
+			// The pages preceding this one are unchanged, they are kept in RAM during the erase.
+			uint32_t kept_size = page_address - subsector_address;
+			UNUSED_RETURN(memcpy((void *)delta_subsector_buffer, (const void *)subsector_address, kept_size));
+			if (!delta_erase_counted) {
+				int32_t extent_index = llkernel_extents_find((uint32_t)delta_feature_ptr);
+				if (0 <= extent_index) {
+					kf_extents[extent_index].erase_count++;
+				}
+				delta_erase_counted = true;
+			}
+			status = llkernel_flash_erase(subsector_address, 1u);
+			UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+			if (FLASH_CTRL_OK == status) {
+				delta_erased_address = subsector_address;
+			}
+			for (uint32_t offset = 0u; (FLASH_CTRL_OK == status) && (offset < kept_size);
+			     offset += flash_ctrl_get_page_size()) {
+				status = llkernel_ctrl_page_write(&delta_subsector_buffer[offset], subsector_address + offset,
+				                                  flash_ctrl_get_page_size());
+			}
+		}
+		UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+	} else {
+		// Nothing to do, the subsector has been erased by the update.
+	}
+
+	if ((FLASH_CTRL_OK == status) && is_write_needed) {
+		status = llkernel_ctrl_page_write(pData, page_address, size);
+	}
+	if (FLASH_CTRL_OK == status) {
+		delta_page_address = page_address;
+	} else {
+		LLKERNEL_ERROR_LOG("%s: flash update 0x%.8x failed\n", __func__, page_address);
+	}
+	return status;
+}
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+
+/**
+ * @brief Programs a page copied by `LLKERNEL_IMPL_copyToROM()`. The page is compared with the flash content first when
+ * it belongs to the feature being updated in place, and is then written whole. The memory mapped mode must be
+ * disabled.
+ *
+ * @param[in] pData The page content.
+ * @param[in] page_address The start address of the destination page.
+ * @param[in] start_offset The offset in the page of the first byte copied, the flash already holds the bytes before.
+ * @param[in] end_offset The offset in the page following the last byte copied.
+ *
+ * @retval FLASH_CTRL_OK on success, FLASH_CTRL_ERROR when the page cannot be written.
+ */
+static uint32_t llkernel_copy_page_write(uint8_t *pData, uint32_t page_address, uint32_t start_offset,
+                                         uint32_t end_offset) {
+	uint32_t status;
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+	if (llkernel_delta_is_active(page_address)) {
+		status = llkernel_delta_page_write(pData, page_address, flash_ctrl_get_page_size());
+	} else
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+	{
+		status = llkernel_page_write_range(pData, page_address, start_offset, end_offset);
+	}
+	return status;
+}
+
+#if (1 == LLKERNEL_FLASH_INFLATE)
+/**
+ * @brief Copies into the flash the decompressed bytes of the window not copied yet.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR if the copy failed.
+ */
+static int32_t llkernel_inflate_copy_window(void) {
+	int32_t result = LLKERNEL_OK;
+	uint32_t size = inflate_write_index - inflate_copy_index;
+
+	if (0u < size) {
+		result = LLKERNEL_IMPL_copyToROM(inflate_dest_ptr, &inflate_window[inflate_copy_index], (int32_t)size);
+		// cppcheck-suppress [misra-c2012-18.4]: points after the + operation.
+		inflate_dest_ptr += size;
+	}
+	inflate_copy_index = inflate_write_index;
+	return result;
+}
+
+/**
+ * @brief Appends a decompressed byte to the window. The window is copied into the flash when it is full.
+ *
+ * @param[in] byte The decompressed byte.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR if the copy failed.
+ */
+static int32_t llkernel_inflate_output(uint8_t byte) {
+	int32_t result = LLKERNEL_OK;
+
+	inflate_window[inflate_write_index] = byte;
+	inflate_write_index++;
+	if (LLKERNEL_INFLATE_WINDOW_SIZE == inflate_write_index) {
+		result = llkernel_inflate_copy_window();
+		inflate_write_index = 0u;
+		inflate_copy_index = 0u;
+	}
+	return result;
+}
+
+/**
+ * @brief Handles a field of the compressed stream once all its bits are read, and selects the next field.
+ *
+ * @retval LLKERNEL_OK on success, LLKERNEL_ERROR if the copy of the decompressed bytes failed.
+ */
+static int32_t llkernel_inflate_read_field(void) {
+	int32_t result = LLKERNEL_OK;
+
+	switch (inflate_field) {
+	case INFLATE_TAG:
+		if (1u == inflate_field_value) {
+			inflate_field = INFLATE_LITERAL;
+			inflate_field_nb_bits = 8u;
+		} else {
+			inflate_field = INFLATE_INDEX;
+			inflate_field_nb_bits = LLKERNEL_FLASH_INFLATE_WINDOW_BITS;
+		}
+		break;
+
+	case INFLATE_LITERAL:
+		result = llkernel_inflate_output((uint8_t)inflate_field_value);
+		inflate_field = INFLATE_TAG;
+		inflate_field_nb_bits = 1u;
+		break;
+
+	case INFLATE_INDEX:
+		inflate_index = inflate_field_value;
+		inflate_field = INFLATE_COUNT;
+		inflate_field_nb_bits = LLKERNEL_FLASH_INFLATE_LOOKAHEAD_BITS;
+		break;
+
+	default: // INFLATE_COUNT
+		// The referenced bytes are in the window, the bytes before the start of the stream are 0.
+		for (uint32_t i = 0; (LLKERNEL_OK == result) && (i <= inflate_field_value); i++) {
+			uint32_t index = (inflate_write_index - inflate_index - 1u) & (LLKERNEL_INFLATE_WINDOW_SIZE - 1u);
+			result = llkernel_inflate_output(inflate_window[index]);
+		}
+		inflate_field = INFLATE_TAG;
+		inflate_field_nb_bits = 1u;
+		break;
+	}
+	inflate_field_value = 0u;
+	return result;
+}
+#endif // LLKERNEL_FLASH_INFLATE
+
+/**
+ * @brief Programs the status word of a feature header. The new status must only clear bits of the current one, so
+ * that it is programmed without erasing the subsector. The memory mapped mode must be enabled when calling this
+ * function, and is enabled when it returns.
+ *
+ * @param[in] feature_ptr The feature header structure pointer.
+ * @param[in] status The new status.
+ *
+ * @retval FLASH_CTRL_OK on success, FLASH_CTRL_ERROR when the flash memory device returned an error.
+ */
+static uint32_t llkernel_feature_set_status(feature_header_t *feature_ptr, uint32_t status) {
+	uint32_t result;
+
+	llkernel_device_select_address((uint32_t)feature_ptr);
+	// The status is the first word of the page of the header.
+	UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+	result = llkernel_ctrl_page_write((uint8_t *)&status, (uint32_t)feature_ptr, sizeof(status));
+	if (FLASH_CTRL_OK != result) {
+		LLKERNEL_ERROR_LOG("%s: Flash error during attempt to write at the address 0x%x in the flash.\n", __func__,
+		                   (uint32_t)feature_ptr);
+	}
+	if (FLASH_CTRL_OK != llkernel_ctrl_enable_memory_mapped_mode()) {
+		LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+	}
+	return result;
+}
+
+/**
+ * @brief Allocates a free area of the KF area to a new feature, erases it and writes the feature header. Only the
+ * header subsector is erased when LLKERNEL_FLASH_LAZY_ERASE is enabled. The CRC of the ROM area is then computed from
+ * the data copied by `LLKERNEL_IMPL_copyToROM()`. The feature is not added to the feature table.
+ *
+ * @param[in] size_ROM The size of the ROM area of the feature.
+ * @param[in] ram_address The address of the RAM area of the feature.
+ * @param[in] size_RAM The size of the RAM area of the feature.
+ * @param[in] status The status of the feature header.
+ * @param[in] replaced_address The handle of the feature replaced by the new one, 0 if none.
+ *
+ * @retval The address of the feature header, 0 if no free area is large enough or if the flash returned an error.
+ */
+static uint32_t llkernel_feature_create(uint32_t size_ROM, uint32_t ram_address, uint32_t size_RAM, uint32_t status,
+                                        uint32_t replaced_address) {
+	uint32_t result = 0;
+	uint32_t current_feature_address = 0;
+	uint32_t nb_subsectors = 0;
+	int32_t extent_index = -1;
+	// cppcheck-suppress [misra-c2012-11.3] : mem_writeBuffer is a byte buffer, cast necessary to use the data.
+	feature_header_t *mem_buffer_feature_ptr = (feature_header_t *)mem_writeBuffer;
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+	const flash_ctrl_device_t *devices = flash_ctrl_get_devices();
+#endif // LLKERNEL_FLASH_NB_DEVICES
+
+	// The header is written from mem_writeBuffer, the page assembled for a feature still being copied is moved first.
+#if (1u < LLKERNEL_FLASH_NB_WRITE_CONTEXTS)
+	UNUSED_RETURN(llkernel_write_contexts_select(-1));
+#else
+	UNUSED_RETURN(llkernel_write_buffer_flush());
+#endif // LLKERNEL_FLASH_NB_WRITE_CONTEXTS
+#if (1 == LLKERNEL_FLASH_LAZY_ERASE)
+	llkernel_lazy_erase_complete();
+#endif // LLKERNEL_FLASH_LAZY_ERASE
+	if (LLKERNEL_MAX_NB_EXTENTS <= kf_nb_extents) {
+		// Makes room in the extent table for the split of a free extent.
+		llkernel_extents_compact();
+	}
+	// The devices are tried in placement order, a device with a maximum feature size only gets the small features.
+	for (uint32_t i = 0; (0 > extent_index) && (i < LLKERNEL_FLASH_NB_DEVICES); i++) {
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+		if ((0u == devices[i].max_feature_size) ||
+		    (devices[i].max_feature_size >= (size_ROM + sizeof(feature_header_t))))
+#endif // LLKERNEL_FLASH_NB_DEVICES
+		{
+			llkernel_device_select(i);
+			nb_subsectors = llkernel_get_nb_subsectors(size_ROM + sizeof(feature_header_t));
+			extent_index = llkernel_extents_find_free(nb_subsectors);
+		}
+	}
+	if (0 <= extent_index) {
+		current_feature_address = llkernel_extents_reserve((uint32_t)extent_index, nb_subsectors);
+	}
+
+	if (0u == current_feature_address) {
+		// no more space for features
+		LLKERNEL_ERROR_LOG("%s: No free area of %d bytes in the KF area\n", __func__,
+		                   (int)(size_ROM + sizeof(feature_header_t)));
+	} else {
+		// Clear all corresponding subsectors
+		kf_extents[extent_index].erase_count++;
+		uint32_t nb_erased_subsectors = nb_subsectors;
+#if (1 == LLKERNEL_FLASH_LAZY_ERASE)
+		// Only the header subsector is erased, the next ones are erased when the ROM area is copied.
+		nb_erased_subsectors = 1u;
+#endif // LLKERNEL_FLASH_LAZY_ERASE
+		if (FLASH_CTRL_OK == llkernel_flash_erase(current_feature_address, nb_erased_subsectors)) {
+			for (uint32_t i = sizeof(feature_header_t); i < flash_ctrl_get_page_size(); i++) {
+				// cppcheck-suppress [misra-c2012-18.4]: points after the + operation
+				*(((uint8_t *)mem_buffer_feature_ptr) + i) = 0xFF;
+			}
+			UNUSED_RETURN(memset((void *)mem_buffer_feature_ptr->install_progress, 0xFF,
+			                     sizeof(mem_buffer_feature_ptr->install_progress)));
+			mem_buffer_feature_ptr->status = status;
+			mem_buffer_feature_ptr->nb_subsectors = nb_subsectors;
+			mem_buffer_feature_ptr->rom_address = current_feature_address + sizeof(feature_header_t);
+			mem_buffer_feature_ptr->rom_size = size_ROM;
+			mem_buffer_feature_ptr->ram_address = ram_address;
+			mem_buffer_feature_ptr->ram_size = size_RAM;
+			mem_buffer_feature_ptr->erase_count = kf_extents[extent_index].erase_count;
+			mem_buffer_feature_ptr->crc = LLKERNEL_CRC32_INIT;
+			mem_buffer_feature_ptr->replaced_address = replaced_address;
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+			// The progress of the installation is recorded.
+			mem_buffer_feature_ptr->install_progress[0] &= ~1u;
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+
+			UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+			// Write feature header in flash to reserve the ROM area.
+			if (FLASH_CTRL_OK != llkernel_page_write_range((uint8_t *)mem_buffer_feature_ptr, current_feature_address,
+			                                               0u, sizeof(feature_header_t))) {
+				LLKERNEL_ERROR_LOG("%s: flash write 0x%.8x failed\n", __func__, (int)current_feature_address);
+			} else {
+				result = current_feature_address;
+				// The pages following the header page are left erased.
+				erased_start_address = current_feature_address + flash_ctrl_get_page_size();
+				erased_end_address = current_feature_address + (nb_subsectors * flash_ctrl_get_subsector_size());
+#if (1 == LLKERNEL_FLASH_LAZY_ERASE)
+				lazy_feature_address = current_feature_address;
+				lazy_erase_address = current_feature_address + flash_ctrl_get_subsector_size();
+				lazy_erase_end_address = erased_end_address;
+#endif // LLKERNEL_FLASH_LAZY_ERASE
+			}
+			if (FLASH_CTRL_OK != llkernel_ctrl_enable_memory_mapped_mode()) {
+				LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+			}
+		}
+
+		if (0u == result) {
+			// The ROM area has not been allocated, give it back to the free extents.
+			llkernel_extents_release(current_feature_address);
+		}
+	}
+
+#if (1 == LLKERNEL_STREAM_CONTEXTS)
+	if (0u != result) {
+		// The CRC and the progress of another feature being copied are kept aside.
+		llkernel_stream_contexts_select((feature_header_t *)result);
+	}
+#endif // LLKERNEL_STREAM_CONTEXTS
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+	if (0u != result) {
+		// The ROM area of the feature is now expected to be copied.
+		crc_feature_ptr = (feature_header_t *)result;
+		crc_next_address = crc_feature_ptr->rom_address;
+		crc_end_address = crc_next_address + crc_feature_ptr->rom_size;
+		crc_value = LLKERNEL_CRC32_INIT;
+	}
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+	if (0u != result) {
+		install_feature_ptr = (feature_header_t *)result;
+		install_next_address = install_feature_ptr->rom_address;
+		install_nb_granules = 0u;
+	}
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+	return result;
+}
+
+/**
+ * @brief Completes the replacements of features interrupted by a reset, see `LLKERNEL_flash_commit_staged_feature()`.
+ * A used feature which still references the feature it replaces has been committed: the replaced feature is removed
+ * if it is still used, then the reference is cleared. Called once the KF area is mounted.
+ */
+static void llkernel_features_complete_replacements(void) {
+	uint32_t i = 0;
+
+	while (i < nb_features) {
+		feature_header_t *feature_ptr = features[i].header;
+		uint32_t replaced_address = feature_ptr->replaced_address;
+		bool removed = false;
+
+		if ((0u != replaced_address) && (0xFFFFFFFFu != replaced_address) &&
+		    (replaced_address != (uint32_t)feature_ptr)) {
+			int32_t index = llkernel_features_find((int32_t)replaced_address);
+			LLKERNEL_WARNING_LOG("%s: feature 0x%.8x replaces 0x%.8x\n", __func__, (uint32_t)feature_ptr,
+			                     replaced_address);
+			if (0 <= index) {
+				UNUSED_RETURN(llkernel_feature_set_status(features[index].header,
+				                                          LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER));
+				llkernel_extents_release(replaced_address);
+				llkernel_features_remove((uint32_t)index);
+				removed = ((uint32_t)index < i);
+			}
+			// cppcheck-suppress [misra-c2012-11.4]: address of the header field in the flash.
+			UNUSED_RETURN(llkernel_flash_program_word((uint32_t)&feature_ptr->replaced_address, 0u));
+		}
+		if (!removed) {
+			i++;
+		}
 	}
-	return result;
 }
 
 // -----------------------------------------------------------------------------
@@ -275,110 +2635,149 @@ static uint32_t llkernel_flash_write(uint8_t *input_buffer, uint32_t flash_start
 // cppcheck-suppress [misra-c2012-5.5]: macro with same name generated in intern/LLKERNEL_impl.h.
 // cppcheck-suppress [misra-c2012-8.7]: API function that can be used in another file.
 int32_t LLKERNEL_IMPL_getAllocatedFeaturesCount(void) {
+	LLKERNEL_FLASH_LOCK();
 	LLKERNEL_DEBUG_LOG("%s\n", __func__);
-	// Not allocated in the stack
-	static uint8_t alloc_feature_buffer[LLKERNEL_FLASH_SUBSECTOR_SIZE] __attribute__((section(
-																						  ".bss.microej.llkernel")));
-
-	feature_header_t *feature_ptr = (feature_header_t *)flash_ctrl_get_kf_start_address();
+	UNUSED_RETURN(llkernel_flash_sync());
+	bool stopped = false; // Set when the walk of the KF areas is stopped.
 	nb_features = 0;
-	// If the number of features remains 0, ensure the last feature pointer is set to NULL.
-	// This avoids an inconsistent state where there are no features, but the pointer is still
-	// set to an address, which may result in an erroneous dereferencing.
-	last_feature_ptr = NULL;
-	uint8_t flash_error_occurred = false;
-	do {
-		if (is_feature_used(feature_ptr->status)) {
-			if (feature_ptr->feature_index != nb_features) {
-				uint8_t *mem_buffer = alloc_feature_buffer;
-				uint32_t subsector_size = flash_ctrl_get_subsector_size();
-				UNUSED_RETURN(memcpy((void *)mem_buffer, (const void *)feature_ptr, subsector_size));
-
-				// cppcheck-suppress [misra-c2012-11.3] : cast used by many C framework to factorize code.
-				feature_header_t *mem_buffer_feature_ptr = (feature_header_t *)mem_buffer;
-				mem_buffer_feature_ptr->feature_index = nb_features;
-
-				UNUSED_RETURN(flash_ctrl_disable_memory_mapped_mode());
-				if (FLASH_CTRL_OK != flash_ctrl_erase_subsector((uint32_t)feature_ptr)) {
-					LLKERNEL_ERROR_LOG(
-						"%s: Flash error during attempt to erase the subsector at the address 0x%x in the flash.\n",
-						__func__, (uint32_t)feature_ptr);
-					flash_error_occurred = true; // Leaves the loop after this iteration.
-				}
-				if (FLASH_CTRL_OK != llkernel_flash_write(mem_buffer, (uint32_t)feature_ptr, subsector_size)) {
-					flash_error_occurred = true; // Leaves the loop after this iteration.
-				}
-				if (FLASH_CTRL_OK != flash_ctrl_enable_memory_mapped_mode()) {
-					LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
-				}
+	kf_nb_extents = 0;
+#if (1 == LLKERNEL_FLASH_STATIC_GEOMETRY)
+	// The parentheses call the controller functions instead of the static geometry macros.
+	if ((LLKERNEL_FLASH_PAGE_SIZE != (flash_ctrl_get_page_size)()) ||
+	    (LLKERNEL_FLASH_SUBSECTOR_SIZE != (flash_ctrl_get_subsector_size)())) {
+		LLKERNEL_ERROR_LOG("%s: flash geometry differs from the static geometry (page %d, subsector %d bytes)\n",
+		                   __func__, (int)LLKERNEL_FLASH_PAGE_SIZE, (int)LLKERNEL_FLASH_SUBSECTOR_SIZE);
+		// The KF area is not walked: no feature is mounted and, without free extent, the allocations fail.
+		stopped = true;
+	}
+#endif // LLKERNEL_FLASH_STATIC_GEOMETRY
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+	delta_feature_ptr = NULL;
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+#if (1 == LLKERNEL_FLASH_STAGED_UPDATE)
+	// A staged update is aborted, its ROM area is free.
+	staged_feature_ptr = NULL;
+#endif // LLKERNEL_FLASH_STAGED_UPDATE
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+	// An interrupted installation is resumed with LLKERNEL_flash_resume_install().
+	install_feature_ptr = NULL;
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+#if (1 == LLKERNEL_STREAM_CONTEXTS)
+	UNUSED_RETURN(memset((void *)stream_contexts, 0, sizeof(stream_contexts)));
+#endif // LLKERNEL_STREAM_CONTEXTS
+#if (1 == LLKERNEL_FLASH_LAZY_ERASE)
+	// The subsectors left by an interrupted installation are erased on resume or by the next feature allocated there.
+	lazy_erase_end_address = 0u;
+#endif // LLKERNEL_FLASH_LAZY_ERASE
+#if (1 == LLKERNEL_FLASH_SCRUB)
+	// The erased subsectors are found again by the next scrub steps.
+	UNUSED_RETURN(memset((void *)kf_scrubbed, 0, sizeof(kf_scrubbed)));
+#endif // LLKERNEL_FLASH_SCRUB
+	// Walk the KF area of each device: the extent of a used feature is skipped, any other subsector is free. The
+	// allocation index of a feature is its position in the KF areas, the flash is not updated.
+	for (uint32_t device = 0; (!stopped) && (device < LLKERNEL_FLASH_NB_DEVICES); device++) {
+		llkernel_device_select(device);
+		uint32_t address = flash_ctrl_get_kf_start_address();
+		uint32_t subsector_size = flash_ctrl_get_subsector_size();
+		uint32_t removed_end_address = 0; // End address of the ROM area of the last removed feature found.
+		uint32_t removed_erase_count = 0;
+
+		while (flash_ctrl_get_kf_end_address() > address) {
+			feature_header_t *feature_ptr = (feature_header_t *)address;
+			uint32_t nb_subsectors = 1u;
+			uint32_t erase_count = 0u;
+			bool used = llkernel_is_feature_header_valid(feature_ptr, LLKERNEL_FEATURE_USED_MAGIC_NUMBER);
+
+			if (used) {
+				nb_subsectors = feature_ptr->nb_subsectors;
+				erase_count = feature_ptr->erase_count;
+#if (1 == LLKERNEL_FLASH_CRC_MOUNT_CHECK)
+				// A feature with an invalid content is dropped, its ROM area is free.
+				used = llkernel_is_feature_crc_valid(feature_ptr);
+#endif // LLKERNEL_FLASH_CRC_MOUNT_CHECK
+			} else if (llkernel_is_feature_header_valid(feature_ptr, LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER) ||
+			           llkernel_is_feature_header_valid(feature_ptr, LLKERNEL_FEATURE_STAGED_MAGIC_NUMBER)) {
+				// The header of a removed feature, or of a staged update never committed, gives the erase count of
+				// the free subsectors of its ROM area.
+				removed_end_address = address + (feature_ptr->nb_subsectors * subsector_size);
+				removed_erase_count = feature_ptr->erase_count;
+			} else if ((LLKERNEL_FEATURE_USED_MAGIC_NUMBER == feature_ptr->status) &&
+			           (feature_ptr->rom_address == (address + LLKERNEL_LEGACY_FEATURE_HEADER_SIZE))) {
+				// The 32-byte header of the versions 1.x is not compatible, the ROM area of the feature is free.
+				LLKERNEL_WARNING_LOG("%s: Feature 0x%.8x installed by a version 1.x dropped, install it again\n",
+				                     __func__, address);
+			} else {
+				// Nothing to do, the erase count of a free subsector is only known in the ROM area of a removed
+				// feature.
+			}
+			if ((!used) && (address < removed_end_address)) {
+				erase_count = removed_erase_count;
+			}
+			if ((used && (LLKERNEL_MAX_NB_FEATURES <= nb_features)) ||
+			    (!llkernel_extents_append(address, nb_subsectors, used, erase_count))) {
+				LLKERNEL_ERROR_LOG("%s: Too many features in the KF area, increase LLKERNEL_MAX_NB_FEATURES (%d)\n",
+				                   __func__, (int)LLKERNEL_MAX_NB_FEATURES);
+				stopped = true;
+				break; // Leaves the loop to return the current nb_features.
 			}
-			last_feature_ptr = feature_ptr;
-			nb_features += 1u;
-		}
 
-		if (!is_feature_used(feature_ptr->status) && !is_feature_removed(feature_ptr->status)) {
-			// free slot for features
-			break; // Leaves the loop to return the current nb_features.
+			if (used) {
+				llkernel_features_add(feature_ptr);
+			}
+			address += nb_subsectors * subsector_size;
 		}
-		feature_ptr = llkernel_get_next_feature(feature_ptr);
-	} while ((NULL != feature_ptr) && (!flash_error_occurred));
+	}
+	kf_mounted = true;
+	llkernel_features_complete_replacements();
+	LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_MOUNT, 0u, nb_features);
+	int32_t result = (int32_t)nb_features;
+	LLKERNEL_FLASH_UNLOCK();
 
-	return nb_features;
+	return result;
 }
 
 // See the header file for the function documentation
 int32_t LLKERNEL_IMPL_getFeatureHandle(int32_t allocation_index) {
+	LLKERNEL_FLASH_LOCK();
 	LLKERNEL_DEBUG_LOG("%s (%d)\n", __func__, allocation_index);
 
 	int32_t result = 0;
-	feature_header_t *feature_ptr = (feature_header_t *)flash_ctrl_get_kf_start_address();
 
 	// Retrieves the feature handle when allocation_index is in nb_features range.
 	if ((uint32_t)allocation_index < nb_features) {
-		uint8_t is_leaving_loop = false;
-		do {
-			if (!is_feature_used(feature_ptr->status) && !is_feature_removed(feature_ptr->status)) {
-				// Reach end of installed features
-				is_leaving_loop = true;
-			}
-
-			if (is_feature_used(feature_ptr->status) && (feature_ptr->feature_index == (uint32_t)allocation_index)) {
-				result = (int32_t)feature_ptr;
-				is_leaving_loop = true;
-			}
-
-			if (true == is_leaving_loop) {
-				break; // Leaves the loop to return the current feature_ptr.
-			}
-			feature_ptr = llkernel_get_next_feature(feature_ptr);
-		}while (NULL != feature_ptr);
+		result = (int32_t)features[allocation_index].header;
 	}
+	LLKERNEL_FLASH_UNLOCK();
 	return result;
 }
 
 // See the header file for the function documentation
 void * LLKERNEL_IMPL_getFeatureAddressRAM(int32_t handle) {
+	LLKERNEL_FLASH_LOCK();
 	LLKERNEL_DEBUG_LOG("%s : 0x%.8x\n", __func__, (uint32_t)handle);
 
 	void *result = NULL;
-	feature_header_t *feature_ptr = (feature_header_t *)handle;
-	if (is_feature_used(feature_ptr->status)) {
-		LLKERNEL_DEBUG_LOG("%s (0x%.8x): 0x%.8x\n", __func__, (uint32_t)handle, feature_ptr->ram_address);
-		result = (void *)feature_ptr->ram_address;
+	int32_t index = llkernel_features_find(handle);
+	if (0 <= index) {
+		LLKERNEL_DEBUG_LOG("%s (0x%.8x): 0x%.8x\n", __func__, (uint32_t)handle, features[index].ram_address);
+		result = (void *)features[index].ram_address;
 	}
+	LLKERNEL_FLASH_UNLOCK();
 	return result;
 }
 
 // See the header file for the function documentation
 void * LLKERNEL_IMPL_getFeatureAddressROM(int32_t handle) {
+	LLKERNEL_FLASH_LOCK();
 	LLKERNEL_DEBUG_LOG("%s 0x%.8x \n", __func__, (uint32_t)handle);
 
 	void *result = NULL;
-	feature_header_t *feature_ptr = (feature_header_t *)handle;
-	if (is_feature_used(feature_ptr->status)) {
-		LLKERNEL_DEBUG_LOG("%s (0x%.8x): 0x%.8x\n", __func__, (uint32_t)handle, feature_ptr->rom_address);
-		result = (void *)feature_ptr->rom_address;
+	int32_t index = llkernel_features_find(handle);
+	if (0 <= index) {
+		LLKERNEL_DEBUG_LOG("%s (0x%.8x): 0x%.8x\n", __func__, (uint32_t)handle, features[index].rom_address);
+		result = (void *)features[index].rom_address;
 	}
+	LLKERNEL_FLASH_UNLOCK();
 	return result;
 }
 
@@ -386,51 +2785,58 @@ void * LLKERNEL_IMPL_getFeatureAddressROM(int32_t handle) {
 void LLKERNEL_IMPL_freeFeature(int32_t handle) {
 	LLKERNEL_DEBUG_LOG("%s : 0x%.8x \n", __func__, (uint32_t)handle);
 
+	LLKERNEL_FLASH_LOCK();
+	LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_FREE, (uint32_t)handle, 0u);
 	feature_header_t *feature_ptr = (feature_header_t *)handle;
-
-	if (is_feature_used(feature_ptr->status)) {
-		// cppcheck-suppress [misra-c2012-11.3] : mem_writeBuffer is a byte buffer, cast necessary to use the data.
-		feature_header_t *mem_buffer_feature_ptr = (feature_header_t *)mem_writeBuffer;
-
-		UNUSED_RETURN(memcpy((void *)mem_buffer_feature_ptr, (const void *)feature_ptr, sizeof(feature_header_t)));
-		mem_buffer_feature_ptr->status = LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER;
-		mem_buffer_feature_ptr->nb_subsectors = 1;
-		uint32_t subsector_address = (uint32_t)handle;
-		UNUSED_RETURN(flash_ctrl_disable_memory_mapped_mode());
-
-		// Erases only the subsector where the feature_header structure is located.
-		if (FLASH_CTRL_OK != flash_ctrl_erase_subsector(subsector_address)) {
-			LLKERNEL_ERROR_LOG(
-				"%s: Flash error during attempt to erase the subsector at the address 0x%x in the flash.\n",
-				__func__, subsector_address);
+	int32_t index = llkernel_features_find(handle);
+
+	if (0 <= index) {
+		UNUSED_RETURN(llkernel_flash_sync());
+		// The pages buffered for the feature are not programmed anymore.
+		int32_t extent_index = llkernel_extents_find((uint32_t)handle);
+		if (0 <= extent_index) {
+			llkernel_write_buffers_discard((uint32_t)handle,
+			                               (uint32_t)handle + llkernel_extents_get_size((uint32_t)extent_index));
 		}
-
-		if (FLASH_CTRL_OK != flash_ctrl_page_write((uint8_t *)mem_buffer_feature_ptr, (uint32_t)feature_ptr,
-		                                           sizeof(feature_ptr))) {
-			LLKERNEL_ERROR_LOG("%s: Flash error during attempt to write at the address 0x%x in the flash.\n", __func__,
-			                   (uint32_t)feature_ptr);
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+		if (crc_feature_ptr == feature_ptr) {
+			crc_feature_ptr = NULL;
 		}
-		if (FLASH_CTRL_OK != flash_ctrl_enable_memory_mapped_mode()) {
-			LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+		if (install_feature_ptr == feature_ptr) {
+			install_feature_ptr = NULL;
 		}
-
-		nb_features -= 1u;
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+#if (1 == LLKERNEL_STREAM_CONTEXTS)
+		llkernel_stream_contexts_discard(feature_ptr);
+#endif // LLKERNEL_STREAM_CONTEXTS
+#if (1 == LLKERNEL_FLASH_LAZY_ERASE)
+		if (lazy_feature_address == (uint32_t)handle) {
+			// The ROM area is erased again by the next feature allocated in it.
+			lazy_erase_end_address = 0u;
+		}
+#endif // LLKERNEL_FLASH_LAZY_ERASE
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+		delta_feature_ptr = NULL;
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+		// The removed magic number only clears bits of the used one.
+		UNUSED_RETURN(llkernel_feature_set_status(feature_ptr, LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER));
+
+		// The ROM area of the feature can be coalesced with the adjacent free areas.
+		llkernel_extents_release((uint32_t)handle);
+		llkernel_features_remove((uint32_t)index);
 	}
+	LLKERNEL_FLASH_UNLOCK();
 }
 
 // See the header file for the function documentation
 int32_t LLKERNEL_IMPL_allocateFeature(int32_t size_ROM, int32_t size_RAM) {
 	LLKERNEL_DEBUG_LOG("%s (0x%.8x, 0x%.8x)\n", __func__, (uint32_t)size_ROM, (uint32_t)size_RAM);
-	// Not allocated in the stack, and ensuring that the buffer is aligned correctly.
-	static uint8_t kernel_ram_buffer[LLKERNEL_RAM_BUFFER_SIZE]
-	__attribute__((section(".bss.microej.llkernel")))
-	__attribute__((aligned(LLKERNEL_RAM_ALIGN_SIZE)));
-
 	int32_t result = -1;
-	uint32_t status = FLASH_CTRL_OK;
 	uint32_t current_feature_address = 0;
-	uint32_t current_ram_address;
-	feature_header_t *mem_buffer_feature_ptr;
+	uint32_t current_ram_address = 0;
+	LLKERNEL_FLASH_LOCK();
 
 	// Check the max number of dynamic feature allocations.
 	if (0u == kernel_max_nb_dynamic_features) {
@@ -439,7 +2845,7 @@ int32_t LLKERNEL_IMPL_allocateFeature(int32_t size_ROM, int32_t size_RAM) {
 	}
 
 	// limit feature  ROM size
-	if (llkernel_get_feature_slot_size_rom_bytes() < ((uint32_t)size_ROM + sizeof(mem_buffer_feature_ptr))) {
+	if (llkernel_get_kf_area_size() < ((uint32_t)size_ROM + sizeof(feature_header_t))) {
 		LLKERNEL_ERROR_LOG("%s: requested ROM size larger than maximum feature size (%d bytes)\n", __func__,
 		                   (int)size_ROM);
 		result = 0;
@@ -453,12 +2859,16 @@ int32_t LLKERNEL_IMPL_allocateFeature(int32_t size_ROM, int32_t size_RAM) {
 	}
 
 	if (0 != result) {
-		// Count feature to update last_feature_ptr;
-		UNUSED_RETURN(LLKERNEL_IMPL_getAllocatedFeaturesCount());
-
-		current_feature_address = (uint32_t)llkernel_get_free_feature_slot( );
+		UNUSED_RETURN(llkernel_flash_sync());
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+		delta_feature_ptr = NULL;
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+		if (!kf_mounted) {
+			// Count feature to build the feature table and the KF area extents;
+			UNUSED_RETURN(LLKERNEL_IMPL_getAllocatedFeaturesCount());
+		}
 
-		if (NULL == (uint32_t *)current_feature_address) {
+		if ((nb_features >= kernel_max_nb_dynamic_features) || (nb_features >= LLKERNEL_MAX_NB_FEATURES)) {
 			// no more space for features
 			LLKERNEL_ERROR_LOG("%s: The maximum number of features installed in flash reached (%d)\n", __func__,
 			                   (int)kernel_max_nb_dynamic_features);
@@ -467,92 +2877,27 @@ int32_t LLKERNEL_IMPL_allocateFeature(int32_t size_ROM, int32_t size_RAM) {
 	}
 
 	if (0 != result) {
-		if (NULL == last_feature_ptr) {
-			// This is the first feature
-			current_ram_address = (uint32_t)&kernel_ram_buffer;
-		} else {
-			if (is_feature_removed(((feature_header_t *)current_feature_address)->status) &&
-			    (((feature_header_t *)current_feature_address)->ram_address >= (uint32_t)&kernel_ram_buffer) &&
-			    (((feature_header_t *)current_feature_address)->ram_address <
-			     (uint32_t)&kernel_ram_buffer + LLKERNEL_RAM_BUFFER_SIZE) &&
-			    ((uint32_t)size_RAM <= ((feature_header_t *)current_feature_address)->ram_size)
-			    ) {
-				// Feature for current slot has been removed, re-use the current slot.
-				current_ram_address = ((feature_header_t *)current_feature_address)->ram_address;
-			} else {
-				// Allocate a new slot for the new feature.
-				current_ram_address = llkernel_get_next_aligned_ram_address(last_feature_ptr->ram_address +
-				                                                            last_feature_ptr->ram_size);
-				if (current_ram_address > ((uint32_t)&kernel_ram_buffer[LLKERNEL_RAM_BUFFER_SIZE - 1u])) {
-					// no more space for feature
-					LLKERNEL_ERROR_LOG("%s: No more space to allocate RAM for feature (overflow of %d bytes)\n",
-					                   __func__,
-					                   (current_ram_address -
-					                    ((uint32_t)&kernel_ram_buffer[LLKERNEL_RAM_BUFFER_SIZE - 1u])));
-					result = 0;
-				}
-			}
-		}
-	}
-
-	// cppcheck-suppress [misra-c2012-11.3] : mem_writeBuffer is a byte buffer, cast necessary to use the data.
-	mem_buffer_feature_ptr = (feature_header_t *)mem_writeBuffer;
-	// Clear all corresponding subsectors
-	uint32_t address = current_feature_address;
-	int nb_subsectors = 0;
-
-	if (0 != result) {
-		// Set rom address and size
-		mem_buffer_feature_ptr->rom_address = current_feature_address + sizeof(feature_header_t);
-		mem_buffer_feature_ptr->rom_size = size_ROM;
-		UNUSED_RETURN(flash_ctrl_disable_memory_mapped_mode());
-		while (address < (mem_buffer_feature_ptr->rom_address + mem_buffer_feature_ptr->rom_size)) {
-			nb_subsectors++;
-			status = flash_ctrl_erase_subsector(address);
-			if (FLASH_CTRL_OK != status) {
-				LLKERNEL_ERROR_LOG("%s: flash erase 0x%.8x failed\n", __func__, (unsigned int)address);
-				result = 0;
-				break;
-			}
-			address += flash_ctrl_get_subsector_size();
-		}
-		if (FLASH_CTRL_OK != flash_ctrl_enable_memory_mapped_mode()) {
-			LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+		// The RAM area is allocated in a hole left by the removed features, or after the allocated ones.
+		current_ram_address = llkernel_features_find_free_ram((uint32_t)size_RAM);
+		if (0u == current_ram_address) {
+			// no more space for feature
+			LLKERNEL_ERROR_LOG("%s: No free RAM area of %d bytes for the feature\n", __func__, (int)size_RAM);
+			result = 0;
 		}
 	}
 
 	if (0 != result) {
-		mem_buffer_feature_ptr->nb_subsectors = nb_subsectors;
-		// Set ram address and size
-		mem_buffer_feature_ptr->ram_address = current_ram_address;
-		mem_buffer_feature_ptr->ram_size = size_RAM;
-
-		// Set status
-		mem_buffer_feature_ptr->status = LLKERNEL_FEATURE_USED_MAGIC_NUMBER;
-
-		for (uint32_t i = sizeof(feature_header_t); i < flash_ctrl_get_page_size(); i++) {
-			// cppcheck-suppress [misra-c2012-18.4]: points after the + operation
-			*(((uint8_t *)mem_buffer_feature_ptr) + i) = 0xFF;
-		}
-
-		mem_buffer_feature_ptr->feature_index = nb_features;
-
-		UNUSED_RETURN(flash_ctrl_disable_memory_mapped_mode());
-		// Write feature header in flash to reserve the ROM area.
-		status = flash_ctrl_page_write((uint8_t *)mem_buffer_feature_ptr, current_feature_address,
-		                               flash_ctrl_get_page_size());
-		if (FLASH_CTRL_OK != status) {
-			LLKERNEL_ERROR_LOG("%s: flash write 0x%.8x failed\n", __func__, (int)address);
+		current_feature_address = llkernel_feature_create((uint32_t)size_ROM, current_ram_address, (uint32_t)size_RAM,
+		                                                  LLKERNEL_FEATURE_USED_MAGIC_NUMBER, 0u);
+		if (0u == current_feature_address) {
 			result = 0;
 		} else {
-			last_feature_ptr = (feature_header_t *)current_feature_address;
-			nb_features += 1u;
-			result = current_feature_address;
-		}
-		if (FLASH_CTRL_OK != flash_ctrl_enable_memory_mapped_mode()) {
-			LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+			llkernel_features_add((feature_header_t *)current_feature_address);
+			result = (int32_t)current_feature_address;
 		}
 	}
+	LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_ALLOCATE, (uint32_t)result, (uint32_t)size_ROM);
+	LLKERNEL_FLASH_UNLOCK();
 
 	return result;
 }
@@ -591,13 +2936,23 @@ int32_t LLKERNEL_IMPL_copyToROM(void *dest_address_ROM, void *src_address, int32
 	                   (uint32_t)src_address, (uint32_t)size); // cppcheck-suppress [misra-c2012-11.6]: void pointer
 	                                                           // cast to display the address targeted.
 
-	int32_t result = LLKERNEL_OK;
+	int32_t result;
 	// cppcheck-suppress [misra-c2012-11.5]: Used for code genericity/abstraction
 	uint8_t *dest_ptr = dest_address_ROM;
 	// cppcheck-suppress [misra-c2012-11.5]: Used for code genericity/abstraction
 	uint8_t *src_ptr = src_address;
 	uint32_t remaining = size;
 
+	LLKERNEL_FLASH_LOCK();
+	LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_COPY, (uint32_t)dest_ptr, (uint32_t)size);
+	llkernel_device_select_address((uint32_t)dest_ptr);
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+	// Handles the programs done since the previous call.
+	result = llkernel_write_buffers_wait(LLKERNEL_WRITE_BUFFER_COUNT);
+#else
+	result = LLKERNEL_OK;
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+
 	if (flash_ctrl_get_kf_start_address() > (uint32_t)dest_ptr ||
 	    (flash_ctrl_get_kf_end_address()) <= (uint32_t)dest_ptr) {
 		LLKERNEL_ERROR_LOG("%s: feature cannot be installed outside of defined ROM area (0x%.8x)\n", __func__,
@@ -612,18 +2967,15 @@ int32_t LLKERNEL_IMPL_copyToROM(void *dest_address_ROM, void *src_address, int32
 			result = LLKERNEL_ERROR;
 		}
 
-		if (llkernel_get_feature_slot_size_rom_bytes() < (uint32_t)size) {
-			LLKERNEL_ERROR_LOG("%s: feature size larger than maximum allowed size (%d bytes)\n", __func__, size);
+		int32_t extent_index = llkernel_extents_find((uint32_t)dest_ptr);
+		if ((0 > extent_index) || (!kf_extents[extent_index].used)) {
+			LLKERNEL_ERROR_LOG("%s: feature cannot be installed outside of an allocated ROM area (0x%.8x)\n",
+			                   __func__, (uint32_t)dest_ptr);
 			result = LLKERNEL_ERROR;
-		}
-
-		uint32_t feature_slot_size = llkernel_get_feature_slot_size_rom_bytes();
-		if (0u != feature_slot_size) {
-			uint32_t index_feature_slot_src_addr = ((uint32_t)dest_ptr - flash_ctrl_get_kf_start_address()) /
-			                                       feature_slot_size;
-			uint32_t index_feature_slot_end_addr = (((uint32_t)dest_ptr + (uint32_t)size -
-			                                         flash_ctrl_get_kf_start_address())) / feature_slot_size;
-			if (index_feature_slot_src_addr != index_feature_slot_end_addr) {
+		} else {
+			uint32_t extent_end_address = kf_extents[extent_index].address +
+			                              llkernel_extents_get_size((uint32_t)extent_index);
+			if (extent_end_address < ((uint32_t)dest_ptr + (uint32_t)size)) {
 				LLKERNEL_ERROR_LOG(
 					"%s: The ROM copy overlaps another feature slot (start addr: 0x%x ; end addr: 0x%x) \n", __func__,
 					(uint32_t)dest_ptr, ((uint32_t)dest_ptr + (uint32_t)size));
@@ -632,6 +2984,18 @@ int32_t LLKERNEL_IMPL_copyToROM(void *dest_address_ROM, void *src_address, int32
 		}
 	}
 
+#if (1u < LLKERNEL_FLASH_NB_WRITE_CONTEXTS)
+	if (LLKERNEL_OK == result) {
+		int32_t extent_index = llkernel_extents_find((uint32_t)dest_ptr);
+		// The page assembled for another feature is kept aside instead of being programmed.
+		result = llkernel_write_contexts_select(extent_index);
+#if (1 == LLKERNEL_STREAM_CONTEXTS)
+		// So are the CRC and the progress of the other feature.
+		llkernel_stream_contexts_select((feature_header_t *)kf_extents[extent_index].address);
+#endif // LLKERNEL_STREAM_CONTEXTS
+	}
+#endif // LLKERNEL_FLASH_NB_WRITE_CONTEXTS
+
 	if (LLKERNEL_OK == result) {
 		if (target_page_address != NULL) {
 			// Check if there are data buffered from previous call.
@@ -640,8 +3004,11 @@ int32_t LLKERNEL_IMPL_copyToROM(void *dest_address_ROM, void *src_address, int32
 			// cppcheck-suppress [misra-c2012-11.6]: new address computation using the value stored in the pointer.
 			uint32_t new_offset = (uint32_t)dest_address_ROM - (uint32_t)target_page_address;
 			if ((new_offset > mem_writeBuffer_offset) && (new_offset < flash_ctrl_get_page_size())) {
-				// Data already copied, bytes skipped to new_offset.
+				// Data already copied, bytes skipped to new_offset are left erased.
 				LLKERNEL_DEBUG_LOG("%s: %d bytes skipped\n", __func__, new_offset - mem_writeBuffer_offset);
+				// cppcheck-suppress [misra-c2012-18.4]: points after the + operation.
+				UNUSED_RETURN(memset((void *)(mem_writeBuffer + mem_writeBuffer_offset), 0xFF,
+				                     new_offset - mem_writeBuffer_offset));
 				mem_writeBuffer_offset = new_offset;
 			} else if (new_offset != mem_writeBuffer_offset) {
 				// Flushes the buffered data from the previous call.
@@ -652,8 +3019,15 @@ int32_t LLKERNEL_IMPL_copyToROM(void *dest_address_ROM, void *src_address, int32
 		}
 	}
 
+#if (1 == LLKERNEL_FLASH_LAZY_ERASE)
+	if (LLKERNEL_OK == result) {
+		// The subsectors of the copy are erased just before being programmed.
+		result = llkernel_lazy_erase((uint32_t)dest_ptr, (uint32_t)dest_ptr + remaining);
+	}
+#endif // LLKERNEL_FLASH_LAZY_ERASE
+
 	if (LLKERNEL_OK == result) {
-		UNUSED_RETURN(flash_ctrl_disable_memory_mapped_mode());
+		UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
 		while (0u < remaining) {
 			uint32_t page_address = flash_ctrl_get_page_address((uint32_t)dest_ptr);
 			uint32_t buffer_offset = (uint32_t)dest_ptr - page_address;
@@ -662,48 +3036,140 @@ int32_t LLKERNEL_IMPL_copyToROM(void *dest_address_ROM, void *src_address, int32
 				copy_size = remaining;
 			}
 
-			// If the buffer offset is not null, we need to read the flash to not overwrite a part of the page.
-			if ((target_page_address == NULL) && (0u != buffer_offset)) {
-				if (FLASH_CTRL_OK != flash_ctrl_enable_memory_mapped_mode()) {
-					LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+#if (1 == LLKERNEL_FLASH_CTRL_WRITE_RANGE)
+			bool is_range_write = (0u == buffer_offset) && (copy_size < remaining);
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+			// The pages of a feature updated in place are compared one by one.
+			is_range_write = is_range_write && !llkernel_delta_is_active(page_address);
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+			if (is_range_write) {
+				// Several whole pages are written at once from the source data.
+				copy_size = remaining - (remaining % flash_ctrl_get_page_size());
+				llkernel_erased_pages_consume(page_address, copy_size);
+				result = llkernel_flash_write_range(src_ptr, page_address, copy_size);
+				if (LLKERNEL_OK != result) {
+					break; // Leaves the loop to return the error code.
 				}
-				const uint32_t *ptr_page_address = (uint32_t *)page_address;
-				LLKERNEL_DEBUG_LOG("%s: page read (addr: 0x%.8x, len: 0x%.8x)\n", __func__,
-				                   (int)ptr_page_address, flash_ctrl_get_page_size());
-				UNUSED_RETURN(memcpy((void *)mem_writeBuffer, (const void *)ptr_page_address,
-				                     flash_ctrl_get_page_size()));
-				UNUSED_RETURN(flash_ctrl_disable_memory_mapped_mode());
-			}
-
-			// Copy into the write buffer the desired content.
-			// cppcheck-suppress [misra-c2012-18.4]: points after the + operation.
-			UNUSED_RETURN(memcpy((void *)((mem_writeBuffer) + buffer_offset), (const void *)src_ptr, copy_size));
-			// cppcheck-suppress [misra-c2012-18.4]: points after the + operation.
-			if (memcmp((uint8_t *)(mem_writeBuffer + buffer_offset), src_ptr, copy_size) != 0) {
-				LLKERNEL_ERROR_LOG("%s: Write to buffer invalid\n", __func__);
-			}
-
-			if ((copy_size + buffer_offset) == flash_ctrl_get_page_size()) {
+			} else
+#endif // LLKERNEL_FLASH_CTRL_WRITE_RANGE
+#if (1 == LLKERNEL_FLASH_ZERO_COPY)
+			if ((NULL == target_page_address) && (flash_ctrl_get_page_size() == copy_size)) {
+				// The whole page is programmed from the source data, without going through mem_writeBuffer.
+				llkernel_erased_pages_consume(page_address, copy_size);
 				LLKERNEL_DEBUG_LOG("%s: page write (addr: 0x%.8x, off: 0x%.8x, len: 0x%.8x)\n", __func__,
-				                   page_address, buffer_offset, (buffer_offset + copy_size));
-				if (FLASH_CTRL_OK != flash_ctrl_page_write((uint8_t *)mem_writeBuffer, page_address,
-				                                           flash_ctrl_get_page_size())) {
+				                   page_address, 0u, copy_size);
+				if (FLASH_CTRL_OK != llkernel_copy_page_write(src_ptr, page_address, 0u, copy_size)) {
 					LLKERNEL_ERROR_LOG("%s: flash write 0x%.8x failed\n", __func__, (int)page_address);
 					result = LLKERNEL_ERROR;
 					break; // Leaves the loop to return the error code.
 				}
-
-				UNUSED_RETURN(flash_ctrl_enable_memory_mapped_mode());
-				if (memcmp((uint8_t *)(page_address + buffer_offset), src_ptr, copy_size) != 0) {
+#if (LLKERNEL_FLASH_VERIFY_PAGE == LLKERNEL_FLASH_VERIFY_MODE)
+				UNUSED_RETURN(llkernel_ctrl_enable_memory_mapped_mode());
+				if (memcmp((uint8_t *)page_address, src_ptr, copy_size) != 0) {
+					LLKERNEL_STATS_ADD(nb_verify_failures, 1u);
 					LLKERNEL_ERROR_LOG("%s: Flash write invalid\n", __func__);
 				}
-				if (memcmp(mem_writeBuffer, (uint8_t *)page_address, flash_ctrl_get_page_size()) != 0) {
-					LLKERNEL_ERROR_LOG("%s: Flash write from buffer invalid\n", __func__);
+				UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+			} else
+#endif // LLKERNEL_FLASH_ZERO_COPY
+			{
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+				// mem_writeBuffer is refilled only once its previous program is done.
+				result = llkernel_write_buffers_wait(LLKERNEL_WRITE_BUFFER_COUNT - 1u);
+				if (LLKERNEL_OK != result) {
+					break; // Leaves the loop to return the error code.
+				}
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+
+				if (target_page_address == NULL) {
+					mem_writeBuffer_start = buffer_offset;
+				}
+				// If the buffer offset is not null, we need to read the flash to not overwrite a part of the page.
+				if ((target_page_address == NULL) && (0u != buffer_offset)) {
+					if (llkernel_is_page_erased(page_address)) {
+						// The page has not been programmed since its erase, the bytes before the offset are erased.
+						UNUSED_RETURN(memset((void *)mem_writeBuffer, 0xFF, buffer_offset));
+					} else {
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+						// The flash can be read once all the queued buffers are programmed.
+						result = llkernel_write_buffers_wait(0u);
+						if (LLKERNEL_OK != result) {
+							break; // Leaves the loop to return the error code.
+						}
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+						if (FLASH_CTRL_OK != llkernel_ctrl_enable_memory_mapped_mode()) {
+							LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+						}
+						const uint32_t *ptr_page_address = (uint32_t *)page_address;
+						LLKERNEL_STATS_ADD(nb_page_reads, 1u);
+						LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_PAGE_READ, page_address, flash_ctrl_get_page_size());
+						LLKERNEL_DEBUG_LOG("%s: page read (addr: 0x%.8x, len: 0x%.8x)\n", __func__,
+						                   (int)ptr_page_address, flash_ctrl_get_page_size());
+						UNUSED_RETURN(memcpy((void *)mem_writeBuffer, (const void *)ptr_page_address,
+						                     flash_ctrl_get_page_size()));
+						UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+					}
+				}
+				llkernel_erased_pages_consume(page_address, flash_ctrl_get_page_size());
+
+				// Copy into the write buffer the desired content.
+				// cppcheck-suppress [misra-c2012-18.4]: points after the + operation.
+				UNUSED_RETURN(memcpy((void *)((mem_writeBuffer) + buffer_offset), (const void *)src_ptr, copy_size));
+
+				if ((copy_size + buffer_offset) == flash_ctrl_get_page_size()) {
+					LLKERNEL_DEBUG_LOG("%s: page write (addr: 0x%.8x, off: 0x%.8x, len: 0x%.8x)\n", __func__,
+					                   page_address, buffer_offset, (buffer_offset + copy_size));
+					// The page is complete, nothing remains buffered.
+					target_page_address = NULL;
+					mem_writeBuffer_offset = 0;
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+					// The next buffer is filled while this one is programmed, the page content is checked by
+					// llkernel_write_buffers_wait().
+					UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+					if (llkernel_delta_is_active(page_address)) {
+						// The page is compared with the flash content once the queued buffers are programmed.
+						result = llkernel_write_buffers_wait(0u);
+						UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+						if ((LLKERNEL_OK == result) &&
+						    (FLASH_CTRL_OK != llkernel_delta_page_write((uint8_t *)mem_writeBuffer, page_address,
+						                                                flash_ctrl_get_page_size()))) {
+							result = LLKERNEL_ERROR;
+						}
+					} else
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+					{
+						result = llkernel_write_buffers_submit(page_address);
+					}
+					if (LLKERNEL_OK != result) {
+						break; // Leaves the loop to return the error code.
+					}
+#else
+					if (FLASH_CTRL_OK != llkernel_copy_page_write((uint8_t *)mem_writeBuffer, page_address,
+					                                              mem_writeBuffer_start, flash_ctrl_get_page_size())) {
+						LLKERNEL_ERROR_LOG("%s: flash write 0x%.8x failed\n", __func__, (int)page_address);
+						result = LLKERNEL_ERROR;
+						break; // Leaves the loop to return the error code.
+					}
+
+#if (LLKERNEL_FLASH_VERIFY_PAGE == LLKERNEL_FLASH_VERIFY_MODE)
+					UNUSED_RETURN(llkernel_ctrl_enable_memory_mapped_mode());
+					if (memcmp((uint8_t *)(page_address + buffer_offset), src_ptr, copy_size) != 0) {
+						LLKERNEL_STATS_ADD(nb_verify_failures, 1u);
+						LLKERNEL_ERROR_LOG("%s: Flash write invalid\n", __func__);
+					}
+					if (memcmp(mem_writeBuffer, (uint8_t *)page_address, flash_ctrl_get_page_size()) != 0) {
+						LLKERNEL_STATS_ADD(nb_verify_failures, 1u);
+						LLKERNEL_ERROR_LOG("%s: Flash write from buffer invalid\n", __func__);
+					}
+					UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+				} else {
+					target_page_address = (uint8_t *)page_address;
+					mem_writeBuffer_offset = copy_size + buffer_offset;
 				}
-				UNUSED_RETURN(flash_ctrl_disable_memory_mapped_mode());
-			} else {
-				target_page_address = (uint8_t *)page_address;
-				mem_writeBuffer_offset = copy_size + buffer_offset;
 			}
 
 			// cppcheck-suppress [misra-c2012-18.4]: points after the + operation.
@@ -714,10 +3180,45 @@ int32_t LLKERNEL_IMPL_copyToROM(void *dest_address_ROM, void *src_address, int32
 			src_ptr += copy_size;
 			remaining -= copy_size;
 		}
-		if (FLASH_CTRL_OK != flash_ctrl_enable_memory_mapped_mode()) {
-			LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+#if (LLKERNEL_FLASH_VERIFY_DEFERRED == LLKERNEL_FLASH_VERIFY_MODE)
+		if (LLKERNEL_OK == result) {
+			// The pages are read back once, all the queued buffers must be programmed.
+			result = llkernel_flash_sync();
+		}
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+		// The memory mapped mode is enabled once the queued buffers are programmed.
+		if (0u == write_buffers_nb_queued)
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+		{
+			if (FLASH_CTRL_OK != llkernel_ctrl_enable_memory_mapped_mode()) {
+				LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+			}
+		}
+#if (LLKERNEL_FLASH_VERIFY_DEFERRED == LLKERNEL_FLASH_VERIFY_MODE)
+		if (LLKERNEL_OK == result) {
+			result = llkernel_verify_copy((uint8_t *)dest_address_ROM, (uint8_t *)src_address, (uint32_t)size);
 		}
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+		if (LLKERNEL_OK == result) {
+			llkernel_crc_stream_update((uint8_t *)dest_address_ROM, (uint8_t *)src_address, (uint32_t)size);
+		} else {
+			crc_feature_ptr = NULL;
+		}
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+		if (LLKERNEL_OK == result) {
+			llkernel_install_update((uint8_t *)dest_address_ROM, (uint32_t)size);
+		} else {
+			install_feature_ptr = NULL;
+		}
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
 	}
+	if (LLKERNEL_OK != result) {
+		LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_ERROR, (uint32_t)dest_address_ROM, (uint32_t)size);
+	}
+	LLKERNEL_FLASH_UNLOCK();
 	return result;
 }
 
@@ -726,24 +3227,534 @@ int32_t LLKERNEL_IMPL_copyToROM(void *dest_address_ROM, void *src_address, int32
 // cppcheck-suppress [misra-c2012-8.7]: API function, external linkage mandatory.
 int32_t LLKERNEL_IMPL_flushCopyToROM(void) {
 	LLKERNEL_DEBUG_LOG("%s\n", __func__);
-	int32_t result = LLKERNEL_OK;
+	LLKERNEL_FLASH_LOCK();
+	LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_FLUSH, (uint32_t)target_page_address, mem_writeBuffer_offset);
+	int32_t result = llkernel_write_buffer_flush();
+#if (1u < LLKERNEL_FLASH_NB_WRITE_CONTEXTS)
+	// The pages kept for the other features are programmed too.
+	for (uint32_t i = 0; i < (LLKERNEL_FLASH_NB_WRITE_CONTEXTS - 1u); i++) {
+		if (NULL != write_contexts[i].target_page_address) {
+			llkernel_write_context_swap(&write_contexts[i]);
+			if (LLKERNEL_OK != llkernel_write_buffer_flush()) {
+				result = LLKERNEL_ERROR;
+			}
+		}
+	}
+#endif // LLKERNEL_FLASH_NB_WRITE_CONTEXTS
+
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+	if (LLKERNEL_OK == result) {
+		// The ROM area is checked once all its data are programmed.
+		result = llkernel_crc_stream_check();
+	}
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+	if ((LLKERNEL_OK == result) && (NULL != install_feature_ptr)) {
+		llkernel_install_record(install_next_address);
+	}
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+#if (1 == LLKERNEL_STREAM_CONTEXTS)
+	if (LLKERNEL_OK == result) {
+		// The pages kept for the other features are programmed, their CRC and progress are completed too.
+		result = llkernel_stream_contexts_complete();
+	}
+#endif // LLKERNEL_STREAM_CONTEXTS
+	if (LLKERNEL_OK != result) {
+		LLKERNEL_TRACE_EVENT(LLKERNEL_FLASH_TRACE_ERROR, 0u, 0u);
+	}
+	LLKERNEL_FLASH_UNLOCK();
+
+	return result;
+}
+
+// -----------------------------------------------------------------------------
+// Public functions
+// -----------------------------------------------------------------------------
+
+// See the header file for the function documentation
+int32_t LLKERNEL_flash_get_nb_extents(void) {
+	LLKERNEL_FLASH_LOCK();
+	if (!kf_mounted) {
+		UNUSED_RETURN(LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	}
+	int32_t result = (int32_t)kf_nb_extents;
+	LLKERNEL_FLASH_UNLOCK();
+	return result;
+}
+
+// See the header file for the function documentation
+int32_t LLKERNEL_flash_get_extent_info(int32_t extent_index, LLKERNEL_flash_extent_info_t *info) {
+	LLKERNEL_FLASH_LOCK();
+	int32_t result = LLKERNEL_ERROR;
+
+	if ((0 <= extent_index) && (extent_index < LLKERNEL_flash_get_nb_extents())) {
+		const kf_extent_t *extent = &kf_extents[extent_index];
+		info->address = extent->address;
+		info->nb_subsectors = extent->nb_subsectors;
+		info->erase_count = extent->erase_count;
+		info->used = extent->used;
+		result = LLKERNEL_OK;
+	}
+	LLKERNEL_FLASH_UNLOCK();
+	return result;
+}
+
+#if (1 == LLKERNEL_FLASH_SCRUB)
+// See the header file for the function documentation
+int32_t LLKERNEL_flash_scrub_step(void) {
+	int32_t result = 0;
+	LLKERNEL_FLASH_LOCK();
+
+	if (!kf_mounted) {
+		UNUSED_RETURN(LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	}
+
+	// The flash is left to the feature installation in progress.
+#if (1 == LLKERNEL_FLASH_CTRL_ASYNC)
+	if ((NULL == target_page_address) && (0u == write_buffers_nb_queued))
+#else
+	if (NULL == target_page_address)
+#endif // LLKERNEL_FLASH_CTRL_ASYNC
+	{
+		uint32_t subsector_address = llkernel_scrub_find_next();
+		if (0u != subsector_address) {
+			result = 1;
+			if (!llkernel_is_flash_blank(subsector_address, flash_ctrl_get_subsector_size())) {
+				LLKERNEL_DEBUG_LOG("%s: erase 0x%.8x\n", __func__, subsector_address);
+				UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+				if (FLASH_CTRL_OK != llkernel_erase_unit(subsector_address, flash_ctrl_get_subsector_size())) {
+					LLKERNEL_ERROR_LOG("%s: flash erase 0x%.8x failed\n", __func__, subsector_address);
+					result = LLKERNEL_ERROR;
+				}
+				if (FLASH_CTRL_OK != llkernel_ctrl_enable_memory_mapped_mode()) {
+					LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+				}
+			}
+			if (1 == result) {
+				llkernel_scrub_set(subsector_address, flash_ctrl_get_subsector_size(), true);
+			}
+		}
+	}
+	LLKERNEL_FLASH_UNLOCK();
+	return result;
+}
+#endif // LLKERNEL_FLASH_SCRUB
+
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+// See the header file for the function documentation
+int32_t LLKERNEL_flash_update_feature(int32_t handle, int32_t size_ROM, int32_t size_RAM) {
+	LLKERNEL_FLASH_LOCK();
+	LLKERNEL_DEBUG_LOG("%s (0x%.8x, 0x%.8x, 0x%.8x)\n", __func__, (uint32_t)handle, (uint32_t)size_ROM,
+	                   (uint32_t)size_RAM);
+	int32_t result = LLKERNEL_ERROR;
+
+	if (!kf_mounted) {
+		UNUSED_RETURN(LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	}
+	// The data copied before are programmed with the rules of the previous installation or update.
+	UNUSED_RETURN(LLKERNEL_IMPL_flushCopyToROM());
+#if (1 == LLKERNEL_FLASH_LAZY_ERASE)
+	// The pages compared by the update are the ones of a completely erased and copied feature.
+	llkernel_lazy_erase_complete();
+#endif // LLKERNEL_FLASH_LAZY_ERASE
+	delta_feature_ptr = NULL;
+	// The pages of the updated feature are erased and programmed again in any order.
+	erased_end_address = 0u;
+#if (1 == LLKERNEL_STREAM_CONTEXTS)
+	// The CRC and the progress of another feature being copied are kept aside.
+	llkernel_stream_contexts_select((feature_header_t *)handle);
+#endif // LLKERNEL_STREAM_CONTEXTS
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+	install_feature_ptr = NULL;
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+	llkernel_device_select_address((uint32_t)handle);
+
+	int32_t index = llkernel_features_find(handle);
+	int32_t extent_index = llkernel_extents_find((uint32_t)handle);
+	if ((0 > index) || (0 > extent_index)) {
+		LLKERNEL_ERROR_LOG("%s: feature 0x%.8x not installed\n", __func__, (uint32_t)handle);
+	} else if ((0 > size_ROM) || (0 > size_RAM) ||
+	           (kf_extents[extent_index].nb_subsectors <
+	            llkernel_get_nb_subsectors((uint32_t)size_ROM + sizeof(feature_header_t))) ||
+	           (features[index].ram_size < (uint32_t)size_RAM)) {
+		LLKERNEL_ERROR_LOG("%s: new build does not fit in the areas of the feature 0x%.8x\n", __func__,
+		                   (uint32_t)handle);
+	} else {
+		feature_header_t *feature_ptr = features[index].header;
+		// cppcheck-suppress [misra-c2012-11.3] : mem_writeBuffer is a byte buffer, cast necessary to use the data.
+		feature_header_t *mem_buffer_feature_ptr = (feature_header_t *)mem_writeBuffer;
+
+		uint32_t status = FLASH_CTRL_OK;
+
+		delta_feature_ptr = feature_ptr;
+		delta_end_address = kf_extents[extent_index].address + llkernel_extents_get_size((uint32_t)extent_index);
+		delta_page_address = 0u;
+		delta_erased_address = 0u;
+		delta_erase_counted = false;
+
+		// The CRC of the new content is computed again.
+		UNUSED_RETURN(memcpy((void *)mem_writeBuffer, (const void *)feature_ptr, sizeof(feature_header_t)));
+		mem_buffer_feature_ptr->rom_size = (uint32_t)size_ROM;
+		mem_buffer_feature_ptr->crc = LLKERNEL_CRC32_INIT;
+		if (0 != memcmp((const void *)mem_writeBuffer, (const void *)feature_ptr, sizeof(feature_header_t))) {
+			// The header subsector is erased, the header page is written as by LLKERNEL_IMPL_allocateFeature().
+			kf_extents[extent_index].erase_count++;
+			delta_erase_counted = true;
+			mem_buffer_feature_ptr->erase_count = kf_extents[extent_index].erase_count;
+			// cppcheck-suppress [misra-c2012-18.4]: points after the + operation.
+			UNUSED_RETURN(memset((void *)(mem_writeBuffer + sizeof(feature_header_t)), 0xFF,
+			                     flash_ctrl_get_page_size() - sizeof(feature_header_t)));
+			UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+			status = llkernel_delta_page_write((uint8_t *)mem_writeBuffer, (uint32_t)feature_ptr,
+			                                   flash_ctrl_get_page_size());
+			if (FLASH_CTRL_OK != llkernel_ctrl_enable_memory_mapped_mode()) {
+				LLKERNEL_ERROR_LOG("%s: Could not enable the memory mapped mode \n", __func__);
+			}
+		}
 
-	if (target_page_address != NULL) {
-		UNUSED_RETURN(flash_ctrl_disable_memory_mapped_mode());
-		uint32_t status = flash_ctrl_page_write((uint8_t *)mem_writeBuffer, (uint32_t)target_page_address,
-		                                        flash_ctrl_get_page_size());
-		UNUSED_RETURN(flash_ctrl_enable_memory_mapped_mode());
 		if (FLASH_CTRL_OK != status) {
-			LLKERNEL_ERROR_LOG("%s: flash write 0x%.8x failed (status=%d)\n", __func__, (uint32_t)target_page_address,
-			                   status);
-			result = LLKERNEL_ERROR;
+			delta_feature_ptr = NULL;
+		} else {
+			features[index].rom_size = (uint32_t)size_ROM;
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+			// The ROM area of the feature is now expected to be copied.
+			crc_feature_ptr = feature_ptr;
+			crc_next_address = feature_ptr->rom_address;
+			crc_end_address = crc_next_address + (uint32_t)size_ROM;
+			crc_value = LLKERNEL_CRC32_INIT;
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+			result = LLKERNEL_OK;
+		}
+	}
+	LLKERNEL_FLASH_UNLOCK();
+	return result;
+}
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+
+#if (1 == LLKERNEL_FLASH_STAGED_UPDATE)
+// See the header file for the function documentation
+void *LLKERNEL_flash_stage_feature(int32_t handle, int32_t size_ROM, int32_t size_RAM) {
+	LLKERNEL_FLASH_LOCK();
+	LLKERNEL_DEBUG_LOG("%s (0x%.8x, 0x%.8x, 0x%.8x)\n", __func__, (uint32_t)handle, (uint32_t)size_ROM,
+	                   (uint32_t)size_RAM);
+	void *result = NULL;
+
+	if (!kf_mounted) {
+		UNUSED_RETURN(LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	}
+	LLKERNEL_flash_abort_staged_feature();
+	UNUSED_RETURN(llkernel_flash_sync());
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+	delta_feature_ptr = NULL;
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+
+	int32_t index = llkernel_features_find(handle);
+	if (0 > index) {
+		LLKERNEL_ERROR_LOG("%s: feature 0x%.8x not installed\n", __func__, (uint32_t)handle);
+	} else if ((0 > size_ROM) || (0 > size_RAM) ||
+	           (llkernel_get_kf_area_size() < ((uint32_t)size_ROM + sizeof(feature_header_t))) ||
+	           (features[index].ram_size < (uint32_t)size_RAM)) {
+		LLKERNEL_ERROR_LOG("%s: new build does not fit in the areas of the feature 0x%.8x\n", __func__,
+		                   (uint32_t)handle);
+	} else {
+		uint32_t address = llkernel_feature_create((uint32_t)size_ROM, features[index].ram_address,
+		                                           (uint32_t)size_RAM, LLKERNEL_FEATURE_STAGED_MAGIC_NUMBER,
+		                                           (uint32_t)handle);
+		if (0u != address) {
+			staged_feature_ptr = (feature_header_t *)address;
+			result = (void *)staged_feature_ptr->rom_address;
+		}
+	}
+	LLKERNEL_FLASH_UNLOCK();
+	return result;
+}
+
+// See the header file for the function documentation
+int32_t LLKERNEL_flash_commit_staged_feature(void) {
+	LLKERNEL_FLASH_LOCK();
+	LLKERNEL_DEBUG_LOG("%s\n", __func__);
+	feature_header_t *feature_ptr = staged_feature_ptr;
+	int32_t result = 0;
+
+	if (NULL == feature_ptr) {
+		LLKERNEL_ERROR_LOG("%s: no update staged\n", __func__);
+	} else {
+		// All the data copied are programmed in the new version, and checked.
+		bool valid = (LLKERNEL_OK == LLKERNEL_IMPL_flushCopyToROM());
+		int32_t index = llkernel_features_find((int32_t)feature_ptr->replaced_address);
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+		// The CRC is stored once the whole ROM area has been copied and matches the flash content.
+		valid = valid && (LLKERNEL_CRC32_INIT != feature_ptr->crc);
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+
+		if ((!valid) || (0 > index)) {
+			LLKERNEL_ERROR_LOG("%s: new version 0x%.8x invalid, update rolled back\n", __func__,
+			                   (uint32_t)feature_ptr);
+			LLKERNEL_flash_abort_staged_feature();
+		} else {
+			feature_header_t *replaced_ptr = features[index].header;
+			uint32_t status;
+
+			// Commit point: the new version is used from now on, the reference to the installed version lets the
+			// next mount complete the replacement.
+			status = llkernel_feature_set_status(feature_ptr, LLKERNEL_FEATURE_USED_MAGIC_NUMBER);
+			if (FLASH_CTRL_OK != status) {
+				LLKERNEL_flash_abort_staged_feature();
+			} else {
+				UNUSED_RETURN(llkernel_feature_set_status(replaced_ptr, LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER));
+				// cppcheck-suppress [misra-c2012-11.4]: address of the header field in the flash.
+				UNUSED_RETURN(llkernel_flash_program_word((uint32_t)&feature_ptr->replaced_address, 0u));
+
+				// The new version takes the allocation index of the installed one.
+				llkernel_extents_release((uint32_t)replaced_ptr);
+				features[index].header = feature_ptr;
+				features[index].rom_address = feature_ptr->rom_address;
+				features[index].rom_size = feature_ptr->rom_size;
+				features[index].ram_address = feature_ptr->ram_address;
+				features[index].ram_size = feature_ptr->ram_size;
+				staged_feature_ptr = NULL;
+				result = (int32_t)feature_ptr;
+			}
+		}
+	}
+	LLKERNEL_FLASH_UNLOCK();
+	return result;
+}
+
+// See the header file for the function documentation
+void LLKERNEL_flash_abort_staged_feature(void) {
+	LLKERNEL_FLASH_LOCK();
+	feature_header_t *feature_ptr = staged_feature_ptr;
+
+	if (NULL != feature_ptr) {
+		LLKERNEL_DEBUG_LOG("%s (0x%.8x)\n", __func__, (uint32_t)feature_ptr);
+		UNUSED_RETURN(LLKERNEL_IMPL_flushCopyToROM());
+		staged_feature_ptr = NULL;
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+		if (crc_feature_ptr == feature_ptr) {
+			crc_feature_ptr = NULL;
+		}
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+		if (install_feature_ptr == feature_ptr) {
+			install_feature_ptr = NULL;
+		}
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+#if (1 == LLKERNEL_STREAM_CONTEXTS)
+		llkernel_stream_contexts_discard(feature_ptr);
+#endif // LLKERNEL_STREAM_CONTEXTS
+#if (1 == LLKERNEL_FLASH_LAZY_ERASE)
+		if (lazy_feature_address == (uint32_t)feature_ptr) {
+			lazy_erase_end_address = 0u;
+		}
+#endif // LLKERNEL_FLASH_LAZY_ERASE
+		// The removed magic number only clears bits of the staged one.
+		UNUSED_RETURN(llkernel_feature_set_status(feature_ptr, LLKERNEL_FEATURE_REMOVED_MAGIC_NUMBER));
+		llkernel_extents_release((uint32_t)feature_ptr);
+	}
+	LLKERNEL_FLASH_UNLOCK();
+}
+#endif // LLKERNEL_FLASH_STAGED_UPDATE
+
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+// See the header file for the function documentation
+int32_t LLKERNEL_flash_get_install_progress(int32_t handle) {
+	LLKERNEL_FLASH_LOCK();
+	int32_t result = LLKERNEL_ERROR;
+
+	if (!kf_mounted) {
+		UNUSED_RETURN(LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	}
+	int32_t index = llkernel_features_find(handle);
+	if (0 <= index) {
+		int32_t nb_granules = llkernel_install_get_nb_granules(features[index].header);
+		if (0 <= nb_granules) {
+			result = (int32_t)llkernel_install_get_progress(features[index].header, (uint32_t)nb_granules);
+		}
+	}
+	LLKERNEL_FLASH_UNLOCK();
+	return result;
+}
+
+// See the header file for the function documentation
+int32_t LLKERNEL_flash_resume_install(int32_t handle) {
+	LLKERNEL_FLASH_LOCK();
+	LLKERNEL_DEBUG_LOG("%s (0x%.8x)\n", __func__, (uint32_t)handle);
+	int32_t result = LLKERNEL_ERROR;
+
+	if (!kf_mounted) {
+		UNUSED_RETURN(LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	}
+	// mem_writeBuffer is used to write the header again.
+	UNUSED_RETURN(LLKERNEL_IMPL_flushCopyToROM());
+	llkernel_device_select_address((uint32_t)handle);
+
+	int32_t index = llkernel_features_find(handle);
+	int32_t extent_index = llkernel_extents_find((uint32_t)handle);
+	int32_t nb_granules = -1;
+	if ((0 <= index) && (0 <= extent_index)) {
+		nb_granules = llkernel_install_get_nb_granules(features[index].header);
+	}
+
+	if (0 > nb_granules) {
+		LLKERNEL_ERROR_LOG("%s: no installation progress of the feature 0x%.8x\n", __func__, (uint32_t)handle);
+	} else {
+		feature_header_t *feature_ptr = features[index].header;
+		uint32_t progress = llkernel_install_get_progress(feature_ptr, (uint32_t)nb_granules);
+
+		if (progress < feature_ptr->rom_size) {
+			// cppcheck-suppress [misra-c2012-11.3] : mem_writeBuffer is a byte buffer, cast necessary to use the data.
+			feature_header_t *mem_buffer_feature_ptr = (feature_header_t *)mem_writeBuffer;
+			uint32_t erase_address = (uint32_t)feature_ptr +
+			                         ((uint32_t)nb_granules * llkernel_install_get_granule_size(feature_ptr));
+			uint32_t end_address = kf_extents[extent_index].address +
+			                       llkernel_extents_get_size((uint32_t)extent_index);
+			uint32_t status;
+
+			// The granules not recorded may have been partially programmed, they are erased.
+			kf_extents[extent_index].erase_count++;
+#if (1 == LLKERNEL_FLASH_LAZY_ERASE)
+			if (lazy_feature_address == (uint32_t)feature_ptr) {
+				lazy_erase_end_address = 0u;
+			}
+#endif // LLKERNEL_FLASH_LAZY_ERASE
+			if (0 == nb_granules) {
+				// The header subsector is erased, the header page is written as by LLKERNEL_IMPL_allocateFeature().
+				UNUSED_RETURN(memset((void *)mem_writeBuffer, 0xFF, flash_ctrl_get_page_size()));
+				UNUSED_RETURN(memcpy((void *)mem_writeBuffer, (const void *)feature_ptr, sizeof(feature_header_t)));
+				mem_buffer_feature_ptr->erase_count = kf_extents[extent_index].erase_count;
+			}
+			status = llkernel_flash_erase(erase_address, (end_address - erase_address) /
+			                              flash_ctrl_get_subsector_size());
+			if ((FLASH_CTRL_OK == status) && (0 == nb_granules)) {
+				UNUSED_RETURN(llkernel_ctrl_disable_memory_mapped_mode());
+				status = llkernel_page_write_range((uint8_t *)mem_writeBuffer, (uint32_t)feature_ptr, 0u,
+				                                   sizeof(feature_header_t));
+				UNUSED_RETURN(llkernel_ctrl_enable_memory_mapped_mode());
+			}
+
+			if (FLASH_CTRL_OK != status) {
+				LLKERNEL_ERROR_LOG("%s: flash erase 0x%.8x failed\n", __func__, erase_address);
+			} else {
+				erased_start_address = (0 == nb_granules) ? (erase_address + flash_ctrl_get_page_size()) :
+				                       erase_address;
+				erased_end_address = end_address;
+#if (1 == LLKERNEL_STREAM_CONTEXTS)
+				// The CRC and the progress of another feature being copied are kept aside.
+				llkernel_stream_contexts_select(feature_ptr);
+#endif // LLKERNEL_STREAM_CONTEXTS
+				install_feature_ptr = feature_ptr;
+				install_next_address = feature_ptr->rom_address + progress;
+				install_nb_granules = (uint32_t)nb_granules;
+#if (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+				// The CRC of the data programmed before the interruption is computed from the flash.
+				crc_feature_ptr = feature_ptr;
+				crc_next_address = install_next_address;
+				crc_end_address = feature_ptr->rom_address + feature_ptr->rom_size;
+				crc_value = llkernel_crc32_update(LLKERNEL_CRC32_INIT, (const uint8_t *)feature_ptr->rom_address,
+				                                  progress);
+#endif // LLKERNEL_FLASH_VERIFY_MODE
+				result = (int32_t)progress;
+			}
+		} else {
+			// The installation is complete.
+			result = (int32_t)progress;
 		}
-		target_page_address = NULL;
-		mem_writeBuffer_offset = 0;
 	}
+	LLKERNEL_FLASH_UNLOCK();
+	return result;
+}
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+
+#if (1 == LLKERNEL_FLASH_INFLATE)
+// See the header file for the function documentation
+void LLKERNEL_flash_inflate_start(void *dest_address_ROM) {
+	LLKERNEL_FLASH_LOCK();
+	// cppcheck-suppress [misra-c2012-11.6]: void pointer cast to display the address targeted.
+	LLKERNEL_DEBUG_LOG("%s(dest=0x%.8x)\n", __func__, (uint32_t)dest_address_ROM);
+	// cppcheck-suppress [misra-c2012-11.5]: Used for code genericity/abstraction
+	inflate_dest_ptr = dest_address_ROM;
+	inflate_field = INFLATE_TAG;
+	inflate_field_value = 0u;
+	inflate_field_nb_bits = 1u;
+	inflate_write_index = 0u;
+	inflate_copy_index = 0u;
+	UNUSED_RETURN(memset((void *)inflate_window, 0, sizeof(inflate_window)));
+	LLKERNEL_FLASH_UNLOCK();
+}
+
+// See the header file for the function documentation
+int32_t LLKERNEL_flash_inflate_copy(const void *src_address, int32_t size) {
+	LLKERNEL_FLASH_LOCK();
+	// cppcheck-suppress [misra-c2012-11.6]: void pointer cast to display the address targeted.
+	LLKERNEL_DEBUG_LOG("%s(src=0x%.8x, size=0x%.8x)\n", __func__, (uint32_t)src_address, (uint32_t)size);
+	// cppcheck-suppress [misra-c2012-11.5]: Used for code genericity/abstraction
+	const uint8_t *src_ptr = src_address;
+	int32_t result = LLKERNEL_OK;
 
+	if (NULL == inflate_dest_ptr) {
+		LLKERNEL_ERROR_LOG("%s: decompression not started\n", __func__);
+		result = LLKERNEL_ERROR;
+	} else {
+		uint32_t start_address = (uint32_t)inflate_dest_ptr;
+		for (int32_t i = 0; (LLKERNEL_OK == result) && (i < size); i++) {
+			// The fields are stored from the most significant bit of the bytes.
+			for (uint32_t mask = 0x80u; (LLKERNEL_OK == result) && (0u != mask); mask >>= 1u) {
+				inflate_field_value = (inflate_field_value << 1u) | ((0u != (src_ptr[i] & mask)) ? 1u : 0u);
+				inflate_field_nb_bits--;
+				if (0u == inflate_field_nb_bits) {
+					result = llkernel_inflate_read_field();
+				}
+			}
+		}
+		if (LLKERNEL_OK == result) {
+			// The bytes decompressed by this call are all copied.
+			result = llkernel_inflate_copy_window();
+		}
+		if (LLKERNEL_OK == result) {
+			result = (int32_t)((uint32_t)inflate_dest_ptr - start_address);
+		} else {
+			inflate_dest_ptr = NULL;
+		}
+	}
+	LLKERNEL_FLASH_UNLOCK();
 	return result;
 }
+#endif // LLKERNEL_FLASH_INFLATE
+
+#if (1 == LLKERNEL_FLASH_STATS)
+// See the header file for the function documentation
+void LLKERNEL_flash_get_stats(LLKERNEL_flash_stats_t *stats) {
+	LLKERNEL_FLASH_LOCK();
+	*stats = llkernel_stats;
+	LLKERNEL_FLASH_UNLOCK();
+}
+
+// See the header file for the function documentation
+void LLKERNEL_flash_reset_stats(void) {
+	LLKERNEL_FLASH_LOCK();
+	UNUSED_RETURN(memset((void *)&llkernel_stats, 0, sizeof(llkernel_stats)));
+	LLKERNEL_FLASH_UNLOCK();
+}
+#endif // LLKERNEL_FLASH_STATS
+
+#if (1 == LLKERNEL_FLASH_TRACE)
+// See the header file for the function documentation
+uint32_t LLKERNEL_flash_trace_read(LLKERNEL_flash_trace_event_t *events, uint32_t max_events) {
+	LLKERNEL_FLASH_LOCK();
+	uint32_t nb_read = (max_events < trace_nb_events) ? max_events : trace_nb_events;
+	// The oldest event not read is the first one.
+	uint32_t index = (trace_head + LLKERNEL_FLASH_TRACE_SIZE - trace_nb_events) % LLKERNEL_FLASH_TRACE_SIZE;
+
+	for (uint32_t i = 0u; i < nb_read; i++) {
+		events[i] = trace_events[index];
+		index = (index + 1u) % LLKERNEL_FLASH_TRACE_SIZE;
+	}
+	trace_nb_events -= nb_read;
+	LLKERNEL_FLASH_UNLOCK();
+	return nb_read;
+}
+#endif // LLKERNEL_FLASH_TRACE
 
 // -----------------------------------------------------------------------------
 // EOF
@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+#
+# Python
+#
+# Copyright 2025 MicroEJ Corp. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be found with this software.
+
+"""Builds a KF area image of the LLKERNEL flash implementation with features already installed.
+
+The image is programmed at the start address of the KF area, in one pass, instead of installing the features one by
+one with LLKERNEL_IMPL_allocateFeature() and LLKERNEL_IMPL_copyToROM(). LLKERNEL_IMPL_getAllocatedFeaturesCount()
+mounts it at the first boot.
+
+Each feature takes a ROM area of whole subsectors, in the order of the command line from the start of the KF area,
+and a RAM area in the kernel RAM buffer (kernel_ram_buffer, see the map file of the firmware). Both areas are placed
+the way LLKERNEL_IMPL_allocateFeature() places them on an erased KF area. The ROM area starts with the 48-byte header:
+
+    offset  field             value
+         0  status            LLKERNEL_FEATURE_USED_MAGIC_NUMBER
+         4  nb_subsectors     number of subsectors of the ROM area, header included
+         8  rom_address       address of the header + 48
+        12  rom_size          size of the ROM section
+        16  ram_address       address of the RAM section, aligned on LLKERNEL_RAM_ALIGN_SIZE
+        20  ram_size          size of the RAM section
+        24  erase_count       1, the erase of the image
+        28  crc               CRC-32 (IEEE 802.3) of the ROM section, 0xFFFFFFFF if not computed
+        32  replaced_address  0
+        36  install_progress  0xFFFFFFFF x 3, the installation progress is not recorded
+
+The fields are 32-bit words in the byte order of the target. The ROM section follows the header, the rest of the
+ROM area and the free subsectors are left erased (0xFF).
+
+The ROM section of a feature is linked by the Kernel for the addresses of its ROM and RAM sections: run with --layout
+to print them, the content must be produced for these addresses. Installing the same features in the same order on
+an erased KF area of a reference board gives the same addresses, the ROM sections can then be read back from there.
+With several flash devices (LLKERNEL_FLASH_NB_DEVICES greater than 1), one image is built for the KF area of each
+device.
+
+Usage: llkernel_kf_image.py --kf-start ADDRESS --kf-size SIZE --ram-buffer ADDRESS [options]
+                            --feature FILE:RAM_SIZE [--feature FILE:RAM_SIZE ...] [-o IMAGE]
+"""
+
+import argparse
+import struct
+import sys
+import zlib
+
+# Size of feature_header_t.
+HEADER_SIZE = 48
+HEADER_FORMAT = "12I"
+
+ERASED_WORD = 0xFFFFFFFF
+
+# Default values of LLKERNEL_flash_configuration.h.
+DEFAULT_USED_MAGIC_NUMBER = 0x181C77E8
+DEFAULT_RAM_BUFFER_SIZE = 100 * 1024
+DEFAULT_RAM_ALIGN_SIZE = 256
+DEFAULT_MAX_NB_FEATURES = 32
+
+
+class Feature:
+    """A feature placed in the KF area image."""
+
+    def __init__(self, path, content, ram_size):
+        self.path = path
+        self.content = content
+        self.ram_size = ram_size
+        self.address = 0
+        self.nb_subsectors = 0
+        self.ram_address = 0
+
+
+def align(value, alignment):
+    """Rounds up a value to a multiple of the alignment."""
+    return (value + alignment - 1) // alignment * alignment
+
+
+def parse_int(text):
+    """Parses a decimal or 0x-prefixed hexadecimal integer."""
+    return int(text, 0)
+
+
+def parse_feature(text):
+    """Parses a FILE:RAM_SIZE feature argument."""
+    path, separator, ram_size = text.rpartition(":")
+    if "" == separator:
+        raise argparse.ArgumentTypeError("expected FILE:RAM_SIZE, got '%s'" % text)
+    try:
+        with open(path, "rb") as rom:
+            content = rom.read()
+    except OSError as error:
+        raise argparse.ArgumentTypeError(str(error))
+    return Feature(path, content, parse_int(ram_size))
+
+
+def place(features, args):
+    """Assigns the ROM and RAM areas of the features.
+
+    Raises ValueError if the features do not fit in the KF area or in the kernel RAM buffer.
+    """
+    address = args.kf_start
+    kf_end = args.kf_start + args.kf_size
+    ram_address = align(args.ram_buffer, args.ram_align)
+    ram_end = args.ram_buffer + args.ram_buffer_size
+    for feature in features:
+        feature.nb_subsectors = align(HEADER_SIZE + len(feature.content), args.subsector_size) // args.subsector_size
+        feature.address = address
+        address += feature.nb_subsectors * args.subsector_size
+        if kf_end < address:
+            raise ValueError("%s: no free area of %d bytes in the KF area"
+                             % (feature.path, HEADER_SIZE + len(feature.content)))
+        feature.ram_address = ram_address
+        if ram_end < (ram_address + feature.ram_size):
+            raise ValueError("%s: no free RAM area of %d bytes for the feature" % (feature.path, feature.ram_size))
+        ram_address = align(ram_address + feature.ram_size, args.ram_align)
+    return address
+
+
+def build(features, end_address, args):
+    """Returns the KF area image of the placed features, up to end_address."""
+    byte_order = ">" if args.big_endian else "<"
+    image = bytearray(b"\xff" * (end_address - args.kf_start))
+    for feature in features:
+        crc = ERASED_WORD if args.no_crc else zlib.crc32(feature.content) & 0xFFFFFFFF
+        header = struct.pack(byte_order + HEADER_FORMAT, args.used_magic, feature.nb_subsectors,
+                             feature.address + HEADER_SIZE, len(feature.content), feature.ram_address,
+                             feature.ram_size, 1, crc, 0, ERASED_WORD, ERASED_WORD, ERASED_WORD)
+        offset = feature.address - args.kf_start
+        image[offset:offset + HEADER_SIZE] = header
+        image[offset + HEADER_SIZE:offset + HEADER_SIZE + len(feature.content)] = feature.content
+    return image
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Builds a KF area image of the LLKERNEL flash implementation with "
+                                     "features already installed.")
+    parser.add_argument("--kf-start", type=parse_int, required=True, help="start address of the KF area")
+    parser.add_argument("--kf-size", type=parse_int, required=True, help="size of the KF area")
+    parser.add_argument("--subsector-size", type=parse_int, default=4096, help="subsector size of the flash")
+    parser.add_argument("--ram-buffer", type=parse_int, required=True, help="address of kernel_ram_buffer")
+    parser.add_argument("--ram-buffer-size", type=parse_int, default=DEFAULT_RAM_BUFFER_SIZE,
+                        help="LLKERNEL_RAM_BUFFER_SIZE")
+    parser.add_argument("--ram-align", type=parse_int, default=DEFAULT_RAM_ALIGN_SIZE, help="LLKERNEL_RAM_ALIGN_SIZE")
+    parser.add_argument("--max-features", type=parse_int, default=DEFAULT_MAX_NB_FEATURES,
+                        help="LLKERNEL_MAX_NB_FEATURES")
+    parser.add_argument("--used-magic", type=parse_int, default=DEFAULT_USED_MAGIC_NUMBER,
+                        help="LLKERNEL_FEATURE_USED_MAGIC_NUMBER")
+    parser.add_argument("--big-endian", action="store_true", help="the target is big-endian")
+    parser.add_argument("--no-crc", action="store_true", help="do not store the CRC-32 of the ROM sections")
+    parser.add_argument("--trim", action="store_true",
+                        help="end the image after the last feature instead of the end of the KF area")
+    parser.add_argument("--layout", action="store_true", help="print the addresses of the features and exit")
+    parser.add_argument("--feature", type=parse_feature, action="append", required=True, metavar="FILE:RAM_SIZE",
+                        help="ROM section of a feature and size of its RAM section, in installation order")
+    parser.add_argument("-o", "--output", help="KF area image, the standard output by default")
+    args = parser.parse_args()
+
+    if (0 != (args.kf_start % args.subsector_size)) or (0 != (args.kf_size % args.subsector_size)):
+        parser.error("the KF area must be aligned on the subsector size")
+    if args.max_features < len(args.feature):
+        parser.error("more than %d features, increase LLKERNEL_MAX_NB_FEATURES" % args.max_features)
+    try:
+        end_address = place(args.feature, args)
+    except ValueError as error:
+        print("error: %s" % error, file=sys.stderr)
+        sys.exit(1)
+
+    if args.layout:
+        for feature in args.feature:
+            print("%-32s header 0x%08x rom 0x%08x size %7d | ram 0x%08x size %7d"
+                  % (feature.path, feature.address, feature.address + HEADER_SIZE, len(feature.content),
+                     feature.ram_address, feature.ram_size))
+        return
+
+    image = build(args.feature, end_address if args.trim else (args.kf_start + args.kf_size), args)
+    if args.output is None:
+        sys.stdout.buffer.write(image)
+    else:
+        with open(args.output, "wb") as output:
+            output.write(image)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,85 @@
+#!/usr/bin/env python3
+#
+# Python
+#
+# Copyright 2025 MicroEJ Corp. All rights reserved.
+# Use of this source code is governed by a BSD-style license that can be found with this software.
+
+"""Decodes the flash operations trace of the LLKERNEL flash implementation.
+
+The input is a binary dump of the LLKERNEL_flash_trace_event_t records read with LLKERNEL_flash_trace_read(), in the
+byte order of the target. Each event is printed on a line with its timestamp, the time elapsed since the previous
+event, its name and its arguments. The gaps in the sequence numbers, events overwritten in the trace ring before
+being read, are reported.
+
+Usage: llkernel_trace_decode.py [--big-endian] [--time-unit UNIT] [FILE]
+"""
+
+import argparse
+import struct
+import sys
+
+# Identifiers of the trace events, must match the LLKERNEL_FLASH_TRACE_* values of LLKERNEL_flash.h.
+EVENT_NAMES = {
+    1: "MOUNT",
+    2: "ALLOCATE",
+    3: "FREE",
+    4: "COPY",
+    5: "FLUSH",
+    6: "PROGRAM",
+    7: "PAGE_READ",
+    8: "ERASE",
+    9: "MMAP_ENABLE",
+    10: "MMAP_DISABLE",
+    11: "ERROR",
+}
+
+# Layout of LLKERNEL_flash_trace_event_t: timestamp, address, size, id, sequence.
+EVENT_FORMAT = "IIIHH"
+EVENT_SIZE = struct.calcsize("<" + EVENT_FORMAT)
+
+
+def decode(data, byte_order, time_unit, out):
+    """Prints the events of a trace dump.
+
+    Returns the number of events lost because of the gaps in the sequence numbers.
+    """
+    if 0 != (len(data) % EVENT_SIZE):
+        print("warning: %d trailing bytes ignored" % (len(data) % EVENT_SIZE), file=sys.stderr)
+    nb_lost = 0
+    previous = None
+    for offset in range(0, len(data) - (len(data) % EVENT_SIZE), EVENT_SIZE):
+        timestamp, address, size, event_id, sequence = struct.unpack_from(byte_order + EVENT_FORMAT, data, offset)
+        delta = 0
+        if previous is not None:
+            gap = (sequence - previous[1] - 1) & 0xFFFF
+            if 0 != gap:
+                out.write("--- %d events lost ---\n" % gap)
+                nb_lost += gap
+            delta = (timestamp - previous[0]) & 0xFFFFFFFF
+        name = EVENT_NAMES.get(event_id, "UNKNOWN(%d)" % event_id)
+        out.write("%5u %10u %s +%-8u %-12s address=0x%08x size=%u\n"
+                  % (sequence, timestamp, time_unit, delta, name, address, size))
+        previous = (timestamp, sequence)
+    return nb_lost
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decodes a binary dump of the LLKERNEL flash operations trace.")
+    parser.add_argument("file", nargs="?", help="binary dump of the trace events, the standard input by default")
+    parser.add_argument("--big-endian", action="store_true", help="the target is big-endian")
+    parser.add_argument("--time-unit", default="ticks", help="unit of LLKERNEL_FLASH_STATS_GET_TIME() for display")
+    args = parser.parse_args()
+
+    if args.file is None:
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.file, "rb") as dump:
+            data = dump.read()
+    nb_lost = decode(data, ">" if args.big_endian else "<", args.time_unit, sys.stdout)
+    if 0 != nb_lost:
+        print("%d events lost" % nb_lost, file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,166 @@
+/*
+ * C
+ *
+ * Copyright 2025 MicroEJ Corp. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be found with this software.
+ */
+
+/**
+ * @file
+ * @brief RAM-backed flash controller simulator used to test and benchmark the LLKERNEL flash implementation on the
+ * host.
+ * @author MicroEJ Developer Team
+ * @version 1.0.3
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef FLASH_CONTROLLER_SIM_H
+#define FLASH_CONTROLLER_SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+#include "flash_controller.h"
+
+// -----------------------------------------------------------------------------
+// Macros and defines
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Size of the simulated KF area. Default is 1 MB.
+ *
+ * The LLKERNEL flash implementation stores addresses on 32 bits: the simulator must be built for a 32-bit host
+ * (for example with `-m32` with GCC).
+ */
+#if !defined(FLASH_SIM_KF_SIZE)
+#define FLASH_SIM_KF_SIZE        (1024u * 1024u) // 1 MB
+#endif // FLASH_SIM_KF_SIZE
+
+/**
+ * @brief Size of the simulated subsector. Default is 4 KB.
+ */
+#if !defined(FLASH_SIM_SUBSECTOR_SIZE)
+#define FLASH_SIM_SUBSECTOR_SIZE (4u * 1024u)
+#endif // FLASH_SIM_SUBSECTOR_SIZE
+
+/**
+ * @brief Size of the simulated page. Default is 256 bytes.
+ */
+#if !defined(FLASH_SIM_PAGE_SIZE)
+#define FLASH_SIM_PAGE_SIZE      (256u)
+#endif // FLASH_SIM_PAGE_SIZE
+
+/**
+ * @brief Size of the simulated erase block. Default is 64 KB.
+ */
+#if !defined(FLASH_SIM_BLOCK_SIZE)
+#define FLASH_SIM_BLOCK_SIZE     (64u * 1024u)
+#endif // FLASH_SIM_BLOCK_SIZE
+
+/**
+ * @brief Number of simulated flash devices, 1 or 2. With 2 devices, `flash_ctrl_get_devices()` is implemented and the
+ * LLKERNEL flash implementation must be built with LLKERNEL_FLASH_NB_DEVICES set to 2. Both devices have the geometry
+ * above and their KF areas follow each other, the `flash_ctrl_*` functions are the ones of the first device. The
+ * counters and the clock are shared by the devices. Default is 1.
+ */
+#if !defined(FLASH_SIM_NB_DEVICES)
+#define FLASH_SIM_NB_DEVICES     1u
+#endif // FLASH_SIM_NB_DEVICES
+
+#if (1u > FLASH_SIM_NB_DEVICES) || (2u < FLASH_SIM_NB_DEVICES)
+	#error "FLASH_SIM_NB_DEVICES must be 1 or 2"
+#endif
+
+/**
+ * @brief Size of the largest feature, header included, placed on the first device when FLASH_SIM_NB_DEVICES is 2, the
+ * larger features are placed on the second device. Default is 64 KB.
+ */
+#if !defined(FLASH_SIM_DEVICE0_MAX_FEATURE_SIZE)
+#define FLASH_SIM_DEVICE0_MAX_FEATURE_SIZE (64u * 1024u)
+#endif // FLASH_SIM_DEVICE0_MAX_FEATURE_SIZE
+
+// -----------------------------------------------------------------------------
+// Typedefs
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Latencies of the simulated flash operations, in microseconds.
+ */
+typedef struct {
+	uint32_t erase_subsector;       /**< Erase of one subsector. */
+	uint32_t erase_block;           /**< Erase of one block. */
+	uint32_t page_program;          /**< Program of one page, whatever the amount of bytes written. */
+	uint32_t mmap_enable;           /**< Switch to the memory mapped mode. */
+	uint32_t mmap_disable;          /**< Switch to the indirect mode. */
+	uint32_t blank_check_subsector; /**< Blank-check of one subsector. */
+	uint32_t crc_kb;                /**< CRC-32 computation of 1 KB. */
+	uint32_t status_poll;           /**< Status poll of an asynchronous operation. */
+} flash_sim_latencies_t;
+
+/**
+ * @brief Number of operations executed by the simulated flash.
+ */
+typedef struct {
+	uint32_t nb_erase_subsector;
+	uint32_t nb_erase_block;
+	uint32_t nb_page_program;
+	uint32_t nb_bytes_programmed;
+	uint32_t nb_mmap_enable;
+	uint32_t nb_mmap_disable;
+	uint32_t nb_blank_check;
+	uint32_t nb_crc;
+	uint32_t nb_erase_suspend;
+	uint32_t nb_errors;             /**< Operations rejected because of a misuse of the flash controller API. */
+	uint32_t max_mmap_disabled_time; /**< Longest time during which the memory mapped mode was disabled, in us. */
+} flash_sim_counters_t;
+
+// -----------------------------------------------------------------------------
+// Public functions
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Erases the whole simulated KF areas, enables the memory mapped mode and resets the counters and the clock.
+ *
+ * @param[in] latencies the latencies of the flash operations, NULL to use the default latencies of a typical QSPI NOR
+ * flash.
+ */
+void flash_sim_init(const flash_sim_latencies_t *latencies);
+
+/**
+ * @brief Resets the counters and the clock without modifying the content of the simulated flash.
+ */
+void flash_sim_reset_counters(void);
+
+/**
+ * @brief Gets the simulated time elapsed since the last reset.
+ *
+ * @retval the simulated time in microseconds.
+ */
+uint32_t flash_sim_get_time(void);
+
+/**
+ * @brief Gets the counters of the simulated flash operations.
+ *
+ * @param[out] counters the structure filled with the current counters.
+ */
+void flash_sim_get_counters(flash_sim_counters_t *counters);
+
+/**
+ * @brief Gets the highest erase count of the subsectors of the simulated KF areas.
+ *
+ * @retval the highest amount of erases of a subsector since flash_sim_init().
+ */
+uint32_t flash_sim_get_max_erase_count(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FLASH_CONTROLLER_SIM_H
@@ -9,10 +9,13 @@
 #include "TextUIRunner.h"
 #include "XMLOutputter.h"
 
+TestRef LLKERNEL_flash_bench_tests(void);
+
 int main(int argc, const char *argv[]) {
 	TextUIRunner_setOutputter(XMLOutputter_outputter());
 	TextUIRunner_start();
 	// Please add your tests here
+	TextUIRunner_runTest(LLKERNEL_flash_bench_tests());
 	TextUIRunner_end();
 	return 0;
 }
@@ -0,0 +1,724 @@
+/*
+ * C
+ *
+ * Copyright 2025 MicroEJ Corp. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be found with this software.
+ */
+
+/**
+ * @file
+ * @brief Benchmark of the LLKERNEL flash implementation over the simulated flash controller.
+ *
+ * Each test replays a workload of the Kernel and reports the amount of flash operations and the simulated time spent
+ * in the flash controller. The simulated flash is erased at the beginning of each test.
+ *
+ * The LLKERNEL flash implementation must be linked with a `_java_max_nb_dynamic_features` symbol greater than or
+ * equal to LLKERNEL_FLASH_BENCH_NB_FEATURES (for example `-Wl,--defsym,_java_max_nb_dynamic_features=16` with GCC).
+ *
+ * The optional features are benchmarked only when enabled, each build of the following matrix runs a set of them:
+ * - default configuration: mount, allocation, installs and churn.
+ * - `-DLLKERNEL_FLASH_DELTA_UPDATE=1 -DLLKERNEL_FLASH_STAGED_UPDATE=1 -DLLKERNEL_FLASH_RESUMABLE_INSTALL=1
+ *   -DLLKERNEL_FLASH_VERIFY_MODE=LLKERNEL_FLASH_VERIFY_CRC`: delta, staged and resumed updates, with the CRC checks.
+ * - `-DLLKERNEL_FLASH_NB_WRITE_CONTEXTS=2u -DLLKERNEL_FLASH_RESUMABLE_INSTALL=1
+ *   -DLLKERNEL_FLASH_VERIFY_MODE=LLKERNEL_FLASH_VERIFY_CRC`: CRC and progress of the interleaved installs.
+ * - `-DLLKERNEL_FLASH_NB_DEVICES=2u -DFLASH_SIM_NB_DEVICES=2u`: placement on two flash devices.
+ * - `-DLLKERNEL_FLASH_TRACE=1 -DLLKERNEL_FLASH_INFLATE=1`: trace ring and compressed install.
+ *
+ * @author MicroEJ Developer Team
+ * @version 1.0.3
+ */
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <embUnit/embUnit.h>
+
+#include "LLKERNEL_impl.h"
+#include "LLKERNEL_flash.h"
+#include "flash_controller_sim.h"
+
+// -----------------------------------------------------------------------------
+// Macros and defines
+// -----------------------------------------------------------------------------
+
+/**
+ * @brief Number of features installed before the boot mount benchmark. Default is 16.
+ */
+#if !defined(LLKERNEL_FLASH_BENCH_NB_FEATURES)
+#define LLKERNEL_FLASH_BENCH_NB_FEATURES  16u
+#endif // LLKERNEL_FLASH_BENCH_NB_FEATURES
+
+/**
+ * @brief Number of install/uninstall cycles of the churn benchmark. Default is 50.
+ */
+#if !defined(LLKERNEL_FLASH_BENCH_NB_CYCLES)
+#define LLKERNEL_FLASH_BENCH_NB_CYCLES    50u
+#endif // LLKERNEL_FLASH_BENCH_NB_CYCLES
+
+#if (FLASH_SIM_NB_DEVICES != LLKERNEL_FLASH_NB_DEVICES)
+	#error "FLASH_SIM_NB_DEVICES must be set to LLKERNEL_FLASH_NB_DEVICES"
+#endif
+
+// Size of the largest feature installed by the benchmarks.
+#define LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE (256u * 1024u)
+
+// Size of the RAM section of the features installed by the benchmarks.
+#define LLKERNEL_FLASH_BENCH_RAM_SIZE     (512)
+
+// Size of the header programmed before the ROM section of a feature.
+#define LLKERNEL_FLASH_BENCH_HEADER_SIZE  (48u)
+
+// -----------------------------------------------------------------------------
+// Global Variables
+// -----------------------------------------------------------------------------
+
+static uint8_t bench_feature_data[LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE];
+
+#if (1 == LLKERNEL_FLASH_INFLATE)
+// Size of the feature installed compressed.
+#define LLKERNEL_FLASH_BENCH_INFLATE_SIZE (64u * 1024u)
+
+// Compressed content, a literal takes 9 bits.
+static uint8_t bench_compressed_data[((LLKERNEL_FLASH_BENCH_INFLATE_SIZE * 9u) / 8u) + 1u];
+#endif // LLKERNEL_FLASH_INFLATE
+
+// Sizes of the chunks given to copyToROM, not aligned on the flash pages.
+static const int32_t bench_chunk_sizes[] = { 1000, 333, 4099, 17, 2048 };
+
+// -----------------------------------------------------------------------------
+// Internal functions
+// -----------------------------------------------------------------------------
+
+static void bench_report(const char *name) {
+	flash_sim_counters_t counters;
+	flash_sim_get_counters(&counters);
+	printf("[BENCH] %-24s time %10u us | erase %5u subsectors %4u blocks | program %6u pages %8u bytes | mmap %5u on %5u"
+	       " off (max %6u us) | blank %5u | crc %5u | max erase count %u\n", name, (unsigned int)flash_sim_get_time(),
+	       (unsigned int)counters.nb_erase_subsector, (unsigned int)counters.nb_erase_block,
+	       (unsigned int)counters.nb_page_program, (unsigned int)counters.nb_bytes_programmed,
+	       (unsigned int)counters.nb_mmap_enable, (unsigned int)counters.nb_mmap_disable,
+	       (unsigned int)counters.max_mmap_disabled_time, (unsigned int)counters.nb_blank_check,
+	       (unsigned int)counters.nb_crc, (unsigned int)flash_sim_get_max_erase_count());
+	TEST_ASSERT_EQUAL_INT(0, (int)counters.nb_errors);
+}
+
+/**
+ * @brief Installs a feature the way the Kernel does: allocation, copy of the content by chunks and flush.
+ *
+ * @param[in] size_ROM the size of the ROM section of the feature.
+ * @param[in] chunk_index the index of the first chunk size used in bench_chunk_sizes.
+ *
+ * @retval the handle of the installed feature, 0 on error.
+ */
+static int32_t bench_install(int32_t size_ROM, uint32_t chunk_index) {
+	int32_t handle = LLKERNEL_IMPL_allocateFeature(size_ROM, LLKERNEL_FLASH_BENCH_RAM_SIZE);
+	if (0 != handle) {
+		uint8_t *rom = (uint8_t *)LLKERNEL_IMPL_getFeatureAddressROM(handle);
+		int32_t offset = 0;
+		int32_t ret = LLKERNEL_OK;
+		while ((LLKERNEL_OK == ret) && (offset < size_ROM)) {
+			int32_t size = bench_chunk_sizes[chunk_index % (sizeof(bench_chunk_sizes) / sizeof(bench_chunk_sizes[0]))];
+			if (size > (size_ROM - offset)) {
+				size = size_ROM - offset;
+			}
+			ret = LLKERNEL_IMPL_copyToROM(rom + offset, &bench_feature_data[offset], size);
+			offset += size;
+			chunk_index++;
+		}
+		if ((LLKERNEL_OK != ret) || (LLKERNEL_OK != LLKERNEL_IMPL_flushCopyToROM()) ||
+		    (0 != memcmp(rom, bench_feature_data, (size_t)size_ROM))) {
+			handle = 0;
+		}
+	}
+	return handle;
+}
+
+/**
+ * @brief Copies a range of bench_feature_data to the same offsets of a ROM section, by chunks of the first chunk size
+ * of bench_chunk_sizes, without flushing the copy.
+ *
+ * @param[in] rom the ROM section of the feature.
+ * @param[in] from the offset of the first byte to copy.
+ * @param[in] to the offset following the last byte to copy.
+ */
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE) || (1 == LLKERNEL_FLASH_STAGED_UPDATE) || (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+static void bench_copy(uint8_t *rom, int32_t from, int32_t to) {
+	for (int32_t offset = from; offset < to; offset += bench_chunk_sizes[0]) {
+		int32_t size = (bench_chunk_sizes[0] < (to - offset)) ? bench_chunk_sizes[0] : (to - offset);
+		TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_IMPL_copyToROM(rom + offset, &bench_feature_data[offset], size));
+	}
+}
+#endif // LLKERNEL_FLASH_DELTA_UPDATE || LLKERNEL_FLASH_STAGED_UPDATE || LLKERNEL_FLASH_RESUMABLE_INSTALL
+
+/**
+ * @brief Installs two features downloaded at the same time, their chunks are copied alternately. The content of the
+ * second feature follows the one of the first feature in bench_feature_data.
+ *
+ * @param[in] sizes_ROM the sizes of the ROM sections of the features.
+ * @param[out] handles the handles of the installed features.
+ */
+static void bench_install_interleaved(const int32_t sizes_ROM[2], int32_t handles[2]) {
+	const int32_t data_offsets[2] = { 0, sizes_ROM[0] };
+	uint8_t *roms[2];
+	int32_t offsets[2] = { 0, 0 };
+	uint32_t chunk_index = 0u;
+	for (uint32_t i = 0; i < 2u; i++) {
+		handles[i] = LLKERNEL_IMPL_allocateFeature(sizes_ROM[i], LLKERNEL_FLASH_BENCH_RAM_SIZE);
+		TEST_ASSERT(0 != handles[i]);
+		roms[i] = (uint8_t *)LLKERNEL_IMPL_getFeatureAddressROM(handles[i]);
+	}
+	while ((offsets[0] < sizes_ROM[0]) || (offsets[1] < sizes_ROM[1])) {
+		uint32_t i = chunk_index % 2u;
+		int32_t size = bench_chunk_sizes[chunk_index % (sizeof(bench_chunk_sizes) / sizeof(bench_chunk_sizes[0]))];
+		if (size > (sizes_ROM[i] - offsets[i])) {
+			size = sizes_ROM[i] - offsets[i];
+		}
+		TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_IMPL_copyToROM(roms[i] + offsets[i],
+		                                                           &bench_feature_data[data_offsets[i] + offsets[i]],
+		                                                           size));
+		offsets[i] += size;
+		chunk_index++;
+	}
+	TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_IMPL_flushCopyToROM());
+	TEST_ASSERT_EQUAL_INT(0, memcmp(roms[0], bench_feature_data, (size_t)sizes_ROM[0]));
+	TEST_ASSERT_EQUAL_INT(0, memcmp(roms[1], &bench_feature_data[data_offsets[1]], (size_t)sizes_ROM[1]));
+}
+
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+/**
+ * @brief Checks if the ROM section of a feature is in the KF area of a device.
+ *
+ * @param[in] handle the handle of the feature.
+ * @param[in] index the index of the device in the `flash_ctrl_get_devices()` array.
+ *
+ * @retval true if the ROM section is in the KF area of the device, false otherwise.
+ */
+static bool bench_is_on_device(int32_t handle, uint32_t index) {
+	const flash_ctrl_device_t *device = &flash_ctrl_get_devices()[index];
+	uint32_t rom = (uint32_t)(uintptr_t)LLKERNEL_IMPL_getFeatureAddressROM(handle);
+	return (device->kf_start_address <= rom) && (rom < device->kf_end_address);
+}
+#endif // LLKERNEL_FLASH_NB_DEVICES
+
+/**
+ * @brief Programs words in a page of the KF area behind the LLKERNEL flash implementation, as written by a previous
+ * firmware or before a reset.
+ *
+ * @param[in] address the address of the first word, in a KF area.
+ * @param[in] data the words to program.
+ * @param[in] size the size of the data in bytes, not crossing the end of the page.
+ */
+static void bench_program(uint32_t address, uint32_t *data, uint32_t size) {
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+	const flash_ctrl_device_t *device = &flash_ctrl_get_devices()[0];
+	for (uint32_t i = 0; i < LLKERNEL_FLASH_NB_DEVICES; i++) {
+		if ((flash_ctrl_get_devices()[i].kf_start_address <= address) &&
+		    (address < flash_ctrl_get_devices()[i].kf_end_address)) {
+			device = &flash_ctrl_get_devices()[i];
+		}
+	}
+	TEST_ASSERT_EQUAL_INT(FLASH_CTRL_OK, (int)device->disable_memory_mapped_mode());
+	TEST_ASSERT_EQUAL_INT(FLASH_CTRL_OK, (int)device->page_write((uint8_t *)data, address, size));
+	TEST_ASSERT_EQUAL_INT(FLASH_CTRL_OK, (int)device->enable_memory_mapped_mode());
+#else
+	TEST_ASSERT_EQUAL_INT(FLASH_CTRL_OK, (int)flash_ctrl_disable_memory_mapped_mode());
+	TEST_ASSERT_EQUAL_INT(FLASH_CTRL_OK, (int)flash_ctrl_page_write((uint8_t *)data, address, size));
+	TEST_ASSERT_EQUAL_INT(FLASH_CTRL_OK, (int)flash_ctrl_enable_memory_mapped_mode());
+#endif // LLKERNEL_FLASH_NB_DEVICES
+}
+
+#if (1 == LLKERNEL_FLASH_INFLATE)
+static uint32_t bench_put_bits(uint32_t bit_index, uint32_t value, uint32_t nb_bits) {
+	for (uint32_t i = nb_bits; 0u < i; i--) {
+		if (0u != (value & (1u << (i - 1u)))) {
+			bench_compressed_data[bit_index / 8u] |= (uint8_t)(0x80u >> (bit_index % 8u));
+		}
+		bit_index++;
+	}
+	return bit_index;
+}
+
+/**
+ * @brief Compresses data with the heatshrink LZSS format, with a greedy search of the longest back-reference.
+ *
+ * @param[in] size the amount of bytes of bench_feature_data to compress into bench_compressed_data.
+ *
+ * @retval the size of the compressed data.
+ */
+static uint32_t bench_compress(uint32_t size) {
+	const uint32_t window_size = 1u << LLKERNEL_FLASH_INFLATE_WINDOW_BITS;
+	const uint32_t max_length = 1u << LLKERNEL_FLASH_INFLATE_LOOKAHEAD_BITS;
+	const uint32_t backref_nb_bits = 1u + LLKERNEL_FLASH_INFLATE_WINDOW_BITS + LLKERNEL_FLASH_INFLATE_LOOKAHEAD_BITS;
+	uint32_t bit_index = 0u;
+	uint32_t i = 0u;
+
+	(void)memset(bench_compressed_data, 0, sizeof(bench_compressed_data));
+	while (i < size) {
+		uint32_t best_length = 0u;
+		uint32_t best_distance = 0u;
+		for (uint32_t distance = 1u; (distance <= window_size) && (distance <= i); distance++) {
+			uint32_t length = 0u;
+			while ((length < max_length) && ((i + length) < size) &&
+			       (bench_feature_data[i + length - distance] == bench_feature_data[i + length])) {
+				length++;
+			}
+			if (length > best_length) {
+				best_length = length;
+				best_distance = distance;
+			}
+		}
+		if ((best_length * 9u) > backref_nb_bits) {
+			bit_index = bench_put_bits(bit_index, 0u, 1u);
+			bit_index = bench_put_bits(bit_index, best_distance - 1u, LLKERNEL_FLASH_INFLATE_WINDOW_BITS);
+			bit_index = bench_put_bits(bit_index, best_length - 1u, LLKERNEL_FLASH_INFLATE_LOOKAHEAD_BITS);
+			i += best_length;
+		} else {
+			bit_index = bench_put_bits(bit_index, 1u, 1u);
+			bit_index = bench_put_bits(bit_index, bench_feature_data[i], 8u);
+			i++;
+		}
+	}
+	return (bit_index + 7u) / 8u;
+}
+#endif // LLKERNEL_FLASH_INFLATE
+
+static void bench_setUp(void) {
+	for (uint32_t i = 0; i < sizeof(bench_feature_data); i++) {
+		bench_feature_data[i] = (uint8_t)((i * 2654435761u) >> 24u);
+	}
+	flash_sim_init(NULL);
+	TEST_ASSERT_EQUAL_INT(0, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	flash_sim_reset_counters();
+}
+
+static void bench_tearDown(void) {
+	// Nothing to do.
+}
+
+// -----------------------------------------------------------------------------
+// Benchmarks
+// -----------------------------------------------------------------------------
+
+static void bench_boot_mount(void) {
+	for (uint32_t i = 0; i < LLKERNEL_FLASH_BENCH_NB_FEATURES; i++) {
+		TEST_ASSERT(0 != bench_install((int32_t)(8u * 1024u) + (int32_t)(i * 100u), i));
+	}
+	bench_report("install features");
+
+	flash_sim_reset_counters();
+	TEST_ASSERT_EQUAL_INT((int)LLKERNEL_FLASH_BENCH_NB_FEATURES, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	bench_report("boot mount");
+}
+
+static void bench_legacy_mount(void) {
+	// Header of a feature installed by a version 1.x, its ROM area starts after 32 bytes.
+	uint32_t address = flash_ctrl_get_kf_start_address();
+	uint32_t header[8] = { LLKERNEL_FEATURE_USED_MAGIC_NUMBER, 1u, address + 32u, 1024u, 0u, 512u, 0u, 0xFFFFFFFFu };
+	bench_program(address, header, sizeof(header));
+
+	// The feature is not mounted and its ROM area is allocated again.
+	TEST_ASSERT_EQUAL_INT(0, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	TEST_ASSERT_EQUAL_INT((int32_t)address, bench_install(16 * 1024, 0u));
+	TEST_ASSERT_EQUAL_INT(1, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+}
+
+static void bench_allocate(void) {
+	// Latency of the allocation call alone, before the content is copied.
+	int32_t handle = LLKERNEL_IMPL_allocateFeature((int32_t)LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE,
+	                                               LLKERNEL_FLASH_BENCH_RAM_SIZE);
+	TEST_ASSERT(0 != handle);
+	bench_report("allocate");
+
+	flash_sim_reset_counters();
+	uint8_t *rom = (uint8_t *)LLKERNEL_IMPL_getFeatureAddressROM(handle);
+	for (uint32_t offset = 0u; offset < LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE; offset += 1024u) {
+		TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_IMPL_copyToROM(rom + offset, &bench_feature_data[offset], 1024));
+	}
+	TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_IMPL_flushCopyToROM());
+	TEST_ASSERT_EQUAL_INT(0, memcmp(rom, bench_feature_data, LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE));
+	bench_report("copy after allocate");
+}
+
+static void bench_large_install(void) {
+	TEST_ASSERT(0 != bench_install((int32_t)LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE, 0u));
+	bench_report("large install");
+
+	// Same install with a size that is not a multiple of the page size.
+	flash_sim_reset_counters();
+	TEST_ASSERT(0 != bench_install((int32_t)LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE - 777, 1u));
+	bench_report("large unaligned install");
+
+	// Same install with sections separated by gaps: most copies start in the middle of a page never programmed.
+	flash_sim_reset_counters();
+	int32_t handle = LLKERNEL_IMPL_allocateFeature((int32_t)LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE,
+	                                               LLKERNEL_FLASH_BENCH_RAM_SIZE);
+	TEST_ASSERT(0 != handle);
+	uint8_t *rom = (uint8_t *)LLKERNEL_IMPL_getFeatureAddressROM(handle);
+	for (uint32_t offset = 0u; (offset + 1000u) <= LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE; offset += 1300u) {
+		TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_IMPL_copyToROM(rom + offset, &bench_feature_data[offset], 1000));
+	}
+	TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_IMPL_flushCopyToROM());
+	for (uint32_t offset = 0u; (offset + 1000u) <= LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE; offset += 1300u) {
+		TEST_ASSERT(0 == memcmp(rom + offset, &bench_feature_data[offset], 1000u));
+	}
+	bench_report("large sparse install");
+}
+
+static void bench_interleaved_install(void) {
+	// Two features downloaded at the same time.
+	const int32_t sizes_ROM[2] = { 96 * 1024, 96 * 1024 };
+	int32_t handles[2];
+	bench_install_interleaved(sizes_ROM, handles);
+	bench_report("interleaved install");
+#if (1u < LLKERNEL_FLASH_NB_WRITE_CONTEXTS) && (LLKERNEL_FLASH_VERIFY_CRC == LLKERNEL_FLASH_VERIFY_MODE)
+	// The CRC of both features is stored in the eighth word of their header.
+	for (uint32_t i = 0; i < 2u; i++) {
+		TEST_ASSERT(0xFFFFFFFFu != ((const uint32_t *)(uintptr_t)handles[i])[7]);
+	}
+#endif // LLKERNEL_FLASH_NB_WRITE_CONTEXTS && LLKERNEL_FLASH_VERIFY_MODE
+#if (1u < LLKERNEL_FLASH_NB_WRITE_CONTEXTS) && (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+	// The progress of both features is recorded until the end of their ROM area.
+	for (uint32_t i = 0; i < 2u; i++) {
+		TEST_ASSERT_EQUAL_INT(sizes_ROM[i], LLKERNEL_flash_get_install_progress(handles[i]));
+	}
+#endif // LLKERNEL_FLASH_NB_WRITE_CONTEXTS && LLKERNEL_FLASH_RESUMABLE_INSTALL
+	TEST_ASSERT_EQUAL_INT(2, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+}
+
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+static void bench_multi_device(void) {
+	// The small features are placed on the first device, the large ones on the second device.
+	const int32_t small_size_ROM = 16 * 1024;
+	const int32_t large_size_ROM = 128 * 1024;
+	int32_t small = bench_install(small_size_ROM, 0u);
+	int32_t large = bench_install(large_size_ROM, 1u);
+	TEST_ASSERT(0 != small);
+	TEST_ASSERT(0 != large);
+	TEST_ASSERT(bench_is_on_device(small, 0u));
+	TEST_ASSERT(bench_is_on_device(large, 1u));
+	bench_report("install on two devices");
+
+	// A small and a large feature downloaded at the same time, the copies alternate between the devices.
+	flash_sim_reset_counters();
+	const int32_t sizes_ROM[2] = { small_size_ROM / 2, large_size_ROM / 2 };
+	int32_t handles[2];
+	bench_install_interleaved(sizes_ROM, handles);
+	TEST_ASSERT(bench_is_on_device(handles[0], 0u));
+	TEST_ASSERT(bench_is_on_device(handles[1], 1u));
+	bench_report("interleaved two devices");
+
+	// One feature is uninstalled on each device, the freed areas are allocated again on the same devices.
+	flash_sim_reset_counters();
+	LLKERNEL_IMPL_freeFeature(small);
+	LLKERNEL_IMPL_freeFeature(handles[1]);
+	small = bench_install(small_size_ROM, 2u);
+	TEST_ASSERT(0 != small);
+	TEST_ASSERT(bench_is_on_device(small, 0u));
+	bench_report("free on two devices");
+
+	// The features of both devices are found at boot.
+	flash_sim_reset_counters();
+	TEST_ASSERT_EQUAL_INT(3, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	bench_report("boot mount two devices");
+	TEST_ASSERT_EQUAL_INT(0, memcmp(LLKERNEL_IMPL_getFeatureAddressROM(small), bench_feature_data,
+	                                (size_t)small_size_ROM));
+	TEST_ASSERT_EQUAL_INT(0, memcmp(LLKERNEL_IMPL_getFeatureAddressROM(large), bench_feature_data,
+	                                (size_t)large_size_ROM));
+	TEST_ASSERT_EQUAL_INT(0, memcmp(LLKERNEL_IMPL_getFeatureAddressROM(handles[0]), bench_feature_data,
+	                                (size_t)sizes_ROM[0]));
+}
+#endif // LLKERNEL_FLASH_NB_DEVICES
+
+static void bench_churn(void) {
+	int32_t resident = bench_install(64 * 1024, 0u);
+	TEST_ASSERT(0 != resident);
+	flash_sim_reset_counters();
+
+	for (uint32_t cycle = 0; cycle < LLKERNEL_FLASH_BENCH_NB_CYCLES; cycle++) {
+		int32_t small = bench_install((int32_t)(10u * 1024u) + (int32_t)(cycle * 37u), cycle);
+		int32_t large = bench_install((int32_t)(96u * 1024u) - (int32_t)(cycle * 53u), cycle + 1u);
+		TEST_ASSERT(0 != small);
+		TEST_ASSERT(0 != large);
+		// Uninstall in a different order every other cycle to fragment the KF area.
+		if (0u == (cycle % 2u)) {
+			LLKERNEL_IMPL_freeFeature(small);
+			LLKERNEL_IMPL_freeFeature(large);
+		} else {
+			LLKERNEL_IMPL_freeFeature(large);
+			LLKERNEL_IMPL_freeFeature(small);
+		}
+	}
+	bench_report("churn");
+
+	flash_sim_reset_counters();
+	TEST_ASSERT_EQUAL_INT(1, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	bench_report("boot mount after churn");
+}
+
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+static void bench_delta_update(void) {
+	int32_t size_ROM = (int32_t)LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE - 777;
+	flash_sim_counters_t install_counters;
+	flash_sim_counters_t counters;
+	int32_t handle = bench_install(size_ROM, 0u);
+	TEST_ASSERT(0 != handle);
+	flash_sim_get_counters(&install_counters);
+
+	// New build with a few changed bytes spread over the feature.
+	for (uint32_t i = 0; i < 5u; i++) {
+		bench_feature_data[(i * 50000u) + 123u] ^= 0x5Au;
+	}
+	flash_sim_reset_counters();
+	TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_flash_update_feature(handle, size_ROM, LLKERNEL_FLASH_BENCH_RAM_SIZE));
+	uint8_t *rom = (uint8_t *)LLKERNEL_IMPL_getFeatureAddressROM(handle);
+	bench_copy(rom, 0, size_ROM);
+	TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_IMPL_flushCopyToROM());
+	TEST_ASSERT_EQUAL_INT(0, memcmp(rom, bench_feature_data, (size_t)size_ROM));
+	bench_report("delta update");
+	// Only the changed pages are programmed again.
+	flash_sim_get_counters(&counters);
+	TEST_ASSERT(counters.nb_page_program < (install_counters.nb_page_program / 10u));
+
+	TEST_ASSERT_EQUAL_INT(1, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	TEST_ASSERT(rom == LLKERNEL_IMPL_getFeatureAddressROM(LLKERNEL_IMPL_getFeatureHandle(0)));
+
+	// Smaller new build in the same areas: the header is written again with the new size.
+	size_ROM -= 5000;
+	for (uint32_t i = 0; i < 5u; i++) {
+		bench_feature_data[(i * 40000u) + 321u] ^= 0xA5u;
+	}
+	flash_sim_reset_counters();
+	TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_flash_update_feature(handle, size_ROM, LLKERNEL_FLASH_BENCH_RAM_SIZE));
+	bench_copy(rom, 0, size_ROM);
+	TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_IMPL_flushCopyToROM());
+	TEST_ASSERT_EQUAL_INT(0, memcmp(rom, bench_feature_data, (size_t)size_ROM));
+	bench_report("delta update resized");
+	flash_sim_get_counters(&counters);
+	TEST_ASSERT(counters.nb_page_program < (install_counters.nb_page_program / 10u));
+
+	// The new header is found at boot, with its CRC when LLKERNEL_FLASH_VERIFY_CRC is enabled.
+	TEST_ASSERT_EQUAL_INT(1, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	TEST_ASSERT(rom == LLKERNEL_IMPL_getFeatureAddressROM(LLKERNEL_IMPL_getFeatureHandle(0)));
+	TEST_ASSERT_EQUAL_INT(0, memcmp(rom, bench_feature_data, (size_t)size_ROM));
+}
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+
+#if (1 == LLKERNEL_FLASH_STAGED_UPDATE)
+static void bench_staged_update(void) {
+	int32_t size_ROM = (int32_t)(LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE / 2u) - 777;
+	int32_t handle = bench_install(size_ROM, 0u);
+	TEST_ASSERT(0 != handle);
+	TEST_ASSERT(0 != bench_install(size_ROM / 4, 1u));
+
+	// New build copied next to the installed version, which stays used until the commit.
+	for (uint32_t i = 0; i < (uint32_t)size_ROM; i++) {
+		bench_feature_data[i] ^= 0x5Au;
+	}
+	flash_sim_reset_counters();
+	uint8_t *rom = (uint8_t *)LLKERNEL_flash_stage_feature(handle, size_ROM, LLKERNEL_FLASH_BENCH_RAM_SIZE);
+	TEST_ASSERT(NULL != rom);
+	bench_copy(rom, 0, size_ROM);
+	TEST_ASSERT(handle == LLKERNEL_IMPL_getFeatureHandle(0));
+	int32_t new_handle = LLKERNEL_flash_commit_staged_feature();
+	TEST_ASSERT(0 != new_handle);
+	bench_report("staged update");
+
+	// The new version has the allocation index of the installed one.
+	TEST_ASSERT(new_handle == LLKERNEL_IMPL_getFeatureHandle(0));
+	TEST_ASSERT(rom == LLKERNEL_IMPL_getFeatureAddressROM(new_handle));
+	TEST_ASSERT_EQUAL_INT(0, memcmp(rom, bench_feature_data, (size_t)size_ROM));
+	TEST_ASSERT_EQUAL_INT(2, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+
+	// An aborted update keeps the installed version.
+	TEST_ASSERT(NULL != LLKERNEL_flash_stage_feature(new_handle, size_ROM, LLKERNEL_FLASH_BENCH_RAM_SIZE));
+	LLKERNEL_flash_abort_staged_feature();
+	TEST_ASSERT_EQUAL_INT(0, LLKERNEL_flash_commit_staged_feature());
+	TEST_ASSERT_EQUAL_INT(2, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	TEST_ASSERT(NULL != LLKERNEL_IMPL_getFeatureAddressRAM(new_handle));
+	TEST_ASSERT_EQUAL_INT(0, memcmp(rom, bench_feature_data, (size_t)size_ROM));
+}
+
+static void bench_interrupted_staged_commit(void) {
+	int32_t size_ROM = (int32_t)(LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE / 2u) - 777;
+	int32_t handle = bench_install(size_ROM, 0u);
+	TEST_ASSERT(0 != handle);
+	TEST_ASSERT(0 != bench_install(size_ROM / 4, 1u));
+	for (uint32_t i = 0; i < (uint32_t)size_ROM; i++) {
+		bench_feature_data[i] ^= 0x5Au;
+	}
+	uint8_t *rom = (uint8_t *)LLKERNEL_flash_stage_feature(handle, size_ROM, LLKERNEL_FLASH_BENCH_RAM_SIZE);
+	TEST_ASSERT(NULL != rom);
+	bench_copy(rom, 0, size_ROM);
+	TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_IMPL_flushCopyToROM());
+
+	// Reset right after the commit point: the new version is used, the installed version is not removed yet.
+	uint32_t address = (uint32_t)(uintptr_t)rom - LLKERNEL_FLASH_BENCH_HEADER_SIZE;
+	uint32_t status = LLKERNEL_FEATURE_USED_MAGIC_NUMBER;
+	TEST_ASSERT(LLKERNEL_FEATURE_STAGED_MAGIC_NUMBER == *(const uint32_t *)(uintptr_t)address);
+	bench_program(address, &status, sizeof(status));
+
+	// The mount completes the replacement: the new version is used and the installed version is removed.
+	flash_sim_reset_counters();
+	TEST_ASSERT_EQUAL_INT(2, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	bench_report("mount interrupted commit");
+	TEST_ASSERT(rom == LLKERNEL_IMPL_getFeatureAddressROM((int32_t)address));
+	TEST_ASSERT(NULL == LLKERNEL_IMPL_getFeatureAddressROM(handle));
+	TEST_ASSERT_EQUAL_INT(0, memcmp(rom, bench_feature_data, (size_t)size_ROM));
+
+	// The replacement is done once: the next mount finds the same features without programming the flash.
+	flash_sim_reset_counters();
+	TEST_ASSERT_EQUAL_INT(2, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	TEST_ASSERT(rom == LLKERNEL_IMPL_getFeatureAddressROM((int32_t)address));
+	flash_sim_counters_t counters;
+	flash_sim_get_counters(&counters);
+	TEST_ASSERT_EQUAL_INT(0, (int)counters.nb_page_program);
+}
+#endif // LLKERNEL_FLASH_STAGED_UPDATE
+
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+static void bench_resumed_install(void) {
+	int32_t size_ROM = (int32_t)LLKERNEL_FLASH_BENCH_MAX_ROM_SIZE - 777;
+	int32_t handle = LLKERNEL_IMPL_allocateFeature(size_ROM, LLKERNEL_FLASH_BENCH_RAM_SIZE);
+	TEST_ASSERT(0 != handle);
+	uint8_t *rom = (uint8_t *)LLKERNEL_IMPL_getFeatureAddressROM(handle);
+	TEST_ASSERT_EQUAL_INT(0, LLKERNEL_flash_get_install_progress(handle));
+
+	// Download interrupted after 100000 bytes, the progress is found again by the next mount.
+	bench_copy(rom, 0, 100000);
+	int32_t progress = LLKERNEL_flash_get_install_progress(handle);
+	TEST_ASSERT((0 < progress) && (progress <= 100000));
+	TEST_ASSERT_EQUAL_INT(1, LLKERNEL_IMPL_getAllocatedFeaturesCount());
+	TEST_ASSERT(handle == LLKERNEL_IMPL_getFeatureHandle(0));
+	TEST_ASSERT_EQUAL_INT(progress, LLKERNEL_flash_get_install_progress(handle));
+
+	// The download restarts from the last durable offset, the granules recorded are not programmed again.
+	flash_sim_reset_counters();
+	int32_t resumed_offset = LLKERNEL_flash_resume_install(handle);
+	TEST_ASSERT(progress <= resumed_offset);
+	TEST_ASSERT(resumed_offset <= 100000);
+	bench_copy(rom, resumed_offset, size_ROM);
+	TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_IMPL_flushCopyToROM());
+	bench_report("resumed install");
+	flash_sim_counters_t counters;
+	flash_sim_get_counters(&counters);
+	TEST_ASSERT(counters.nb_bytes_programmed < ((uint32_t)(size_ROM - resumed_offset) + FLASH_SIM_SUBSECTOR_SIZE));
+
+	TEST_ASSERT_EQUAL_INT(0, memcmp(rom, bench_feature_data, (size_t)size_ROM));
+	TEST_ASSERT_EQUAL_INT(size_ROM, LLKERNEL_flash_get_install_progress(handle));
+	TEST_ASSERT_EQUAL_INT(size_ROM, LLKERNEL_flash_resume_install(handle));
+}
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+
+#if (1 == LLKERNEL_FLASH_TRACE)
+static void bench_trace(void) {
+	LLKERNEL_flash_trace_event_t events[16];
+	uint32_t nb_events_by_id[LLKERNEL_FLASH_TRACE_ERROR + 1u] = { 0 };
+	uint32_t nb_events = 0u;
+	uint32_t nb_read;
+	uint16_t next_sequence = 0u;
+
+	// The events of the previous tests are dropped.
+	do {
+		nb_read = LLKERNEL_flash_trace_read(events, 16u);
+	} while (0u != nb_read);
+	TEST_ASSERT(0 != bench_install(64 * 1024, 0u));
+	TEST_ASSERT(0 != bench_install(4 * 1024, 1u));
+
+	do {
+		nb_read = LLKERNEL_flash_trace_read(events, 16u);
+		for (uint32_t i = 0u; i < nb_read; i++) {
+			TEST_ASSERT((0u < events[i].id) && (LLKERNEL_FLASH_TRACE_ERROR >= events[i].id));
+			// The events read are consecutive.
+			TEST_ASSERT((0u == nb_events) || (next_sequence == events[i].sequence));
+			next_sequence = (uint16_t)(events[i].sequence + 1u);
+			nb_events_by_id[events[i].id]++;
+			nb_events++;
+		}
+	} while (0u != nb_read);
+	printf("[BENCH] trace                    %u events | copy %u | flush %u | program %u | erase %u | mmap %u on"
+	       " %u off\n", (unsigned int)nb_events, (unsigned int)nb_events_by_id[LLKERNEL_FLASH_TRACE_COPY],
+	       (unsigned int)nb_events_by_id[LLKERNEL_FLASH_TRACE_FLUSH],
+	       (unsigned int)nb_events_by_id[LLKERNEL_FLASH_TRACE_PROGRAM],
+	       (unsigned int)nb_events_by_id[LLKERNEL_FLASH_TRACE_ERASE],
+	       (unsigned int)nb_events_by_id[LLKERNEL_FLASH_TRACE_MMAP_ENABLE],
+	       (unsigned int)nb_events_by_id[LLKERNEL_FLASH_TRACE_MMAP_DISABLE]);
+	// The ring keeps the most recent events, including the allocation and the flush of the last install.
+	TEST_ASSERT((0u < nb_events) && (LLKERNEL_FLASH_TRACE_SIZE >= nb_events));
+	TEST_ASSERT(0u < nb_events_by_id[LLKERNEL_FLASH_TRACE_ALLOCATE]);
+	TEST_ASSERT_EQUAL_INT(0, (int)nb_events_by_id[LLKERNEL_FLASH_TRACE_ERROR]);
+	TEST_ASSERT(0u < nb_events_by_id[LLKERNEL_FLASH_TRACE_FLUSH]);
+}
+#endif // LLKERNEL_FLASH_TRACE
+
+#if (1 == LLKERNEL_FLASH_INFLATE)
+static void bench_inflate_install(void) {
+	// Content made of a small set of words to be compressible as an executable code.
+	for (uint32_t i = 0; i < LLKERNEL_FLASH_BENCH_INFLATE_SIZE; i++) {
+		uint32_t word = ((i / 4u) * 2654435761u) >> 28u;
+		bench_feature_data[i] = (uint8_t)((word * 0x9Du) + (i % 4u));
+	}
+	uint32_t compressed_size = bench_compress(LLKERNEL_FLASH_BENCH_INFLATE_SIZE);
+	printf("[BENCH] compressed %u bytes into %u bytes\n", (unsigned int)LLKERNEL_FLASH_BENCH_INFLATE_SIZE,
+	       (unsigned int)compressed_size);
+
+	int32_t handle = LLKERNEL_IMPL_allocateFeature((int32_t)LLKERNEL_FLASH_BENCH_INFLATE_SIZE,
+	                                               LLKERNEL_FLASH_BENCH_RAM_SIZE);
+	TEST_ASSERT(0 != handle);
+	uint8_t *rom = (uint8_t *)LLKERNEL_IMPL_getFeatureAddressROM(handle);
+	int32_t decompressed_size = 0;
+	LLKERNEL_flash_inflate_start(rom);
+	for (uint32_t offset = 0u; offset < compressed_size; offset += (uint32_t)bench_chunk_sizes[1]) {
+		uint32_t size = (uint32_t)bench_chunk_sizes[1];
+		if (size > (compressed_size - offset)) {
+			size = compressed_size - offset;
+		}
+		int32_t ret = LLKERNEL_flash_inflate_copy(&bench_compressed_data[offset], (int32_t)size);
+		TEST_ASSERT(0 <= ret);
+		decompressed_size += ret;
+	}
+	TEST_ASSERT_EQUAL_INT(LLKERNEL_OK, LLKERNEL_IMPL_flushCopyToROM());
+	TEST_ASSERT_EQUAL_INT((int)LLKERNEL_FLASH_BENCH_INFLATE_SIZE, decompressed_size);
+	TEST_ASSERT_EQUAL_INT(0, memcmp(rom, bench_feature_data, LLKERNEL_FLASH_BENCH_INFLATE_SIZE));
+	bench_report("compressed install");
+}
+#endif // LLKERNEL_FLASH_INFLATE
+
+// -----------------------------------------------------------------------------
+// Public functions
+// -----------------------------------------------------------------------------
+
+TestRef LLKERNEL_flash_bench_tests(void) {
+	EMB_UNIT_TESTFIXTURES(fixtures) {
+		new_TestFixture("bench_boot_mount", bench_boot_mount),
+		new_TestFixture("bench_legacy_mount", bench_legacy_mount),
+		new_TestFixture("bench_allocate", bench_allocate),
+		new_TestFixture("bench_large_install", bench_large_install),
+		new_TestFixture("bench_interleaved_install", bench_interleaved_install),
+		new_TestFixture("bench_churn", bench_churn),
+#if (1u < LLKERNEL_FLASH_NB_DEVICES)
+		new_TestFixture("bench_multi_device", bench_multi_device),
+#endif // LLKERNEL_FLASH_NB_DEVICES
+#if (1 == LLKERNEL_FLASH_DELTA_UPDATE)
+		new_TestFixture("bench_delta_update", bench_delta_update),
+#endif // LLKERNEL_FLASH_DELTA_UPDATE
+#if (1 == LLKERNEL_FLASH_STAGED_UPDATE)
+		new_TestFixture("bench_staged_update", bench_staged_update),
+		new_TestFixture("bench_interrupted_staged_commit", bench_interrupted_staged_commit),
+#endif // LLKERNEL_FLASH_STAGED_UPDATE
+#if (1 == LLKERNEL_FLASH_RESUMABLE_INSTALL)
+		new_TestFixture("bench_resumed_install", bench_resumed_install),
+#endif // LLKERNEL_FLASH_RESUMABLE_INSTALL
+#if (1 == LLKERNEL_FLASH_TRACE)
+		new_TestFixture("bench_trace", bench_trace),
+#endif // LLKERNEL_FLASH_TRACE
+#if (1 == LLKERNEL_FLASH_INFLATE)
+		new_TestFixture("bench_inflate_install", bench_inflate_install),
+#endif // LLKERNEL_FLASH_INFLATE
+	};
+	EMB_UNIT_TESTCALLER(bench, "LLKERNEL_flash_bench", bench_setUp, bench_tearDown, fixtures);
+	return (TestRef)&bench;
+}
@@ -0,0 +1,645 @@
+/*
+ * C
+ *
+ * Copyright 2025 MicroEJ Corp. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be found with this software.
+ */
+
+/**
+ * @file
+ * @brief RAM-backed implementation of the flash controller layer.
+ *
+ * The simulated flash has the NOR semantics: an erase sets all the bits of a subsector or a block to 1, a program
+ * only clears bits. Reads are done from the memory mapped area, programs and erases are rejected while the memory
+ * mapped mode is enabled. Each operation advances a simulated clock by its configured latency. Each device has its own
+ * memory, erase counts, memory mapped mode and pending asynchronous operations.
+ *
+ * @author MicroEJ Developer Team
+ * @version 1.0.3
+ */
+
+// -----------------------------------------------------------------------------
+// Includes
+// -----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "flash_controller_sim.h"
+
+// -----------------------------------------------------------------------------
+// Macros and defines
+// -----------------------------------------------------------------------------
+
+#define FLASH_SIM_NB_SUBSECTORS (FLASH_SIM_KF_SIZE / FLASH_SIM_SUBSECTOR_SIZE)
+
+#define FLASH_SIM_ERASED_BYTE   (0xFFu)
+
+#define FLASH_SIM_ERROR(...)    do { printf("[FLASH_SIM][E] "); printf(__VA_ARGS__); } while (false)
+
+// -----------------------------------------------------------------------------
+// Typedefs
+// -----------------------------------------------------------------------------
+
+// State of a simulated flash device.
+typedef struct {
+	uint8_t *memory;
+	uint32_t erase_counts[FLASH_SIM_NB_SUBSECTORS];
+	bool mmap_enabled;
+	// Pending asynchronous page write.
+	uint8_t *async_data;
+	uint32_t async_address;
+	uint32_t async_size;
+	uint32_t async_end_time;
+	// Pending asynchronous erase, none when erase_size is 0.
+	uint32_t erase_address;
+	uint32_t erase_size;
+	uint32_t erase_end_time;
+	uint32_t erase_remaining_time;
+	bool erase_suspended;
+	// Time of the last switch to the indirect mode.
+	uint32_t mmap_disable_time;
+} flash_sim_device_t;
+
+// -----------------------------------------------------------------------------
+// Global Variables
+// -----------------------------------------------------------------------------
+
+// Latencies of a typical QSPI NOR flash, in microseconds.
+static const flash_sim_latencies_t flash_sim_default_latencies = {
+	.erase_subsector = 45000u,
+	.erase_block = 150000u,
+	.page_program = 350u,
+	.mmap_enable = 5u,
+	.mmap_disable = 5u,
+	.blank_check_subsector = 40u,
+	.crc_kb = 10u,
+	.status_poll = 20u,
+};
+
+// The KF areas of the devices follow each other.
+static uint8_t flash_sim_memory[FLASH_SIM_NB_DEVICES][FLASH_SIM_KF_SIZE] __attribute__((aligned(FLASH_SIM_BLOCK_SIZE)));
+
+static flash_sim_device_t flash_sim_devices[FLASH_SIM_NB_DEVICES] = {
+	{ .memory = flash_sim_memory[0], .mmap_enabled = true },
+#if (2u == FLASH_SIM_NB_DEVICES)
+	{ .memory = flash_sim_memory[1], .mmap_enabled = true },
+#endif // FLASH_SIM_NB_DEVICES
+};
+
+static flash_sim_latencies_t flash_sim_latencies;
+
+static flash_sim_counters_t flash_sim_counters;
+
+static uint32_t flash_sim_time;
+
+#if (2u == FLASH_SIM_NB_DEVICES)
+// Devices returned by flash_ctrl_get_devices(), filled by flash_sim_init().
+static flash_ctrl_device_t flash_sim_ctrl_devices[FLASH_SIM_NB_DEVICES];
+#endif // FLASH_SIM_NB_DEVICES
+
+// -----------------------------------------------------------------------------
+// Internal functions
+// -----------------------------------------------------------------------------
+
+static uint32_t flash_sim_start_address(const flash_sim_device_t *device) {
+	return (uint32_t)(uintptr_t)device->memory;
+}
+
+/**
+ * @brief Checks that an access to the simulated flash is inside the KF area and is not done in memory mapped mode.
+ *
+ * @param[in] device the accessed device.
+ * @param[in] function the name of the calling function.
+ * @param[in] addr the start address of the access.
+ * @param[in] size the size of the access.
+ *
+ * @retval true if the access is valid, false otherwise.
+ */
+static bool flash_sim_check_access(const flash_sim_device_t *device, const char *function, uint32_t addr,
+                                   uint32_t size) {
+	bool valid = true;
+	if (device->mmap_enabled) {
+		FLASH_SIM_ERROR("%s: memory mapped mode enabled\n", function);
+		valid = false;
+	} else if (NULL != device->async_data) {
+		FLASH_SIM_ERROR("%s: asynchronous write in progress\n", function);
+		valid = false;
+	} else if (0u != device->erase_size) {
+		FLASH_SIM_ERROR("%s: asynchronous erase in progress\n", function);
+		valid = false;
+	} else if ((flash_sim_start_address(device) > addr) ||
+	           ((flash_sim_start_address(device) + FLASH_SIM_KF_SIZE) < (addr + size))) {
+		FLASH_SIM_ERROR("%s: 0x%08x (%u bytes) out of the KF area\n", function, (unsigned int)addr, (unsigned int)size);
+		valid = false;
+	} else {
+		// Valid access.
+	}
+	if (!valid) {
+		flash_sim_counters.nb_errors++;
+	}
+	return valid;
+}
+
+static void flash_sim_erase(flash_sim_device_t *device, uint32_t addr, uint32_t size) {
+	uint32_t offset = addr - flash_sim_start_address(device);
+	(void)memset(&device->memory[offset], (int)FLASH_SIM_ERASED_BYTE, size);
+	for (uint32_t i = offset / FLASH_SIM_SUBSECTOR_SIZE; i < ((offset + size) / FLASH_SIM_SUBSECTOR_SIZE); i++) {
+		device->erase_counts[i]++;
+	}
+}
+
+static void flash_sim_program(flash_sim_device_t *device, const uint8_t *pData, uint32_t addr, uint32_t size) {
+	uint8_t *dest = &device->memory[addr - flash_sim_start_address(device)];
+	// Programming can only clear bits.
+	for (uint32_t i = 0; i < size; i++) {
+		dest[i] &= pData[i];
+	}
+	flash_sim_counters.nb_page_program++;
+	flash_sim_counters.nb_bytes_programmed += size;
+}
+
+static bool flash_sim_check_page(const flash_sim_device_t *device, const char *function, uint32_t addr,
+                                 uint32_t size) {
+	bool valid = flash_sim_check_access(device, function, addr, size);
+	if (valid && ((FLASH_SIM_PAGE_SIZE < size) || (FLASH_SIM_PAGE_SIZE < ((addr % FLASH_SIM_PAGE_SIZE) + size)))) {
+		FLASH_SIM_ERROR("%s: 0x%08x (%u bytes) crosses a page boundary\n", function, (unsigned int)addr,
+		                (unsigned int)size);
+		flash_sim_counters.nb_errors++;
+		valid = false;
+	}
+	return valid;
+}
+
+
+// Operations of a device, called by the flash controller functions of the device.
+
+static uint32_t flash_sim_page_write(flash_sim_device_t *device, uint8_t *pData, uint32_t addr, uint32_t size) {
+	uint32_t ret = FLASH_CTRL_ERROR;
+	if (flash_sim_check_page(device, __func__, addr, size)) {
+		flash_sim_program(device, pData, addr, size);
+		flash_sim_time += flash_sim_latencies.page_program;
+		ret = FLASH_CTRL_OK;
+	}
+	return ret;
+}
+
+static uint32_t flash_sim_erase_subsector(flash_sim_device_t *device, uint32_t addr) {
+	uint32_t ret = FLASH_CTRL_ERROR;
+	uint32_t subsector_address = flash_ctrl_get_subsector_address(addr);
+	if (flash_sim_check_access(device, __func__, subsector_address, FLASH_SIM_SUBSECTOR_SIZE)) {
+		flash_sim_erase(device, subsector_address, FLASH_SIM_SUBSECTOR_SIZE);
+		flash_sim_counters.nb_erase_subsector++;
+		flash_sim_time += flash_sim_latencies.erase_subsector;
+		ret = FLASH_CTRL_OK;
+	}
+	return ret;
+}
+
+static uint32_t flash_sim_enable_memory_mapped_mode(flash_sim_device_t *device) {
+	uint32_t ret = FLASH_CTRL_OK;
+	if (NULL != device->async_data) {
+		FLASH_SIM_ERROR("%s: asynchronous write in progress\n", __func__);
+		flash_sim_counters.nb_errors++;
+		ret = FLASH_CTRL_ERROR;
+	} else if ((0u != device->erase_size) && !device->erase_suspended) {
+		FLASH_SIM_ERROR("%s: asynchronous erase in progress\n", __func__);
+		flash_sim_counters.nb_errors++;
+		ret = FLASH_CTRL_ERROR;
+	} else if (!device->mmap_enabled) {
+		device->mmap_enabled = true;
+		flash_sim_counters.nb_mmap_enable++;
+		flash_sim_time += flash_sim_latencies.mmap_enable;
+		if (flash_sim_counters.max_mmap_disabled_time < (flash_sim_time - device->mmap_disable_time)) {
+			flash_sim_counters.max_mmap_disabled_time = flash_sim_time - device->mmap_disable_time;
+		}
+	} else {
+		// Already enabled.
+	}
+	return ret;
+}
+
+static uint32_t flash_sim_disable_memory_mapped_mode(flash_sim_device_t *device) {
+	if (device->mmap_enabled) {
+		device->mmap_enabled = false;
+		flash_sim_counters.nb_mmap_disable++;
+		device->mmap_disable_time = flash_sim_time;
+		flash_sim_time += flash_sim_latencies.mmap_disable;
+	}
+	return FLASH_CTRL_OK;
+}
+
+static uint32_t flash_sim_blank_check(const flash_sim_device_t *device, uint32_t addr, uint32_t size) {
+	const uint8_t *data = &device->memory[addr - flash_sim_start_address(device)];
+	uint32_t ret = FLASH_CTRL_OK;
+	for (uint32_t i = 0; i < size; i++) {
+		if (FLASH_SIM_ERASED_BYTE != data[i]) {
+			ret = FLASH_CTRL_NOT_BLANK;
+			break;
+		}
+	}
+	flash_sim_counters.nb_blank_check++;
+	flash_sim_time += flash_sim_latencies.blank_check_subsector * ((size + FLASH_SIM_SUBSECTOR_SIZE - 1u) /
+	                                                             FLASH_SIM_SUBSECTOR_SIZE);
+	return ret;
+}
+
+static uint32_t flash_sim_erase_block(flash_sim_device_t *device, uint32_t addr) {
+	uint32_t ret = FLASH_CTRL_ERROR;
+	if (0u != (addr % FLASH_SIM_BLOCK_SIZE)) {
+		FLASH_SIM_ERROR("%s: 0x%08x not aligned on a block\n", __func__, (unsigned int)addr);
+		flash_sim_counters.nb_errors++;
+	} else if (flash_sim_check_access(device, __func__, addr, FLASH_SIM_BLOCK_SIZE)) {
+		flash_sim_erase(device, addr, FLASH_SIM_BLOCK_SIZE);
+		flash_sim_counters.nb_erase_block++;
+		flash_sim_time += flash_sim_latencies.erase_block;
+		ret = FLASH_CTRL_OK;
+	} else {
+		// Error already logged.
+	}
+	return ret;
+}
+
+static uint32_t flash_sim_page_write_async(flash_sim_device_t *device, uint8_t *pData, uint32_t addr,
+                                           uint32_t size) {
+	uint32_t ret = FLASH_CTRL_ERROR;
+	if (flash_sim_check_page(device, __func__, addr, size)) {
+		// The data is programmed at the end of the operation: the buffer must not be modified until then.
+		device->async_data = pData;
+		device->async_address = addr;
+		device->async_size = size;
+		device->async_end_time = flash_sim_time + flash_sim_latencies.page_program;
+		ret = FLASH_CTRL_OK;
+	}
+	return ret;
+}
+
+static uint32_t flash_sim_get_operation_status(flash_sim_device_t *device) {
+	uint32_t ret = FLASH_CTRL_OK;
+	if (NULL != device->async_data) {
+		flash_sim_time += flash_sim_latencies.status_poll;
+		if (device->async_end_time > flash_sim_time) {
+			ret = FLASH_CTRL_BUSY;
+		} else {
+			flash_sim_program(device, device->async_data, device->async_address, device->async_size);
+			device->async_data = NULL;
+		}
+	} else if ((0u != device->erase_size) && !device->erase_suspended) {
+		flash_sim_time += flash_sim_latencies.status_poll;
+		if (device->erase_end_time > flash_sim_time) {
+			ret = FLASH_CTRL_BUSY;
+		} else {
+			flash_sim_erase(device, device->erase_address, device->erase_size);
+			if (FLASH_SIM_SUBSECTOR_SIZE == device->erase_size) {
+				flash_sim_counters.nb_erase_subsector++;
+			} else {
+				flash_sim_counters.nb_erase_block++;
+			}
+			device->erase_size = 0u;
+		}
+	} else {
+		// No operation in progress.
+	}
+	return ret;
+}
+
+static uint32_t flash_sim_erase_async(flash_sim_device_t *device, uint32_t addr, uint32_t size) {
+	uint32_t ret = FLASH_CTRL_ERROR;
+	if (((FLASH_SIM_SUBSECTOR_SIZE != size) && (FLASH_SIM_BLOCK_SIZE != size)) || (0u != (addr % size))) {
+		FLASH_SIM_ERROR("%s: 0x%08x (%u bytes) is not a subsector or a block\n", __func__, (unsigned int)addr,
+		                (unsigned int)size);
+		flash_sim_counters.nb_errors++;
+	} else if (flash_sim_check_access(device, __func__, addr, size)) {
+		// The memory is erased at the end of the operation.
+		device->erase_address = addr;
+		device->erase_size = size;
+		device->erase_suspended = false;
+		device->erase_end_time = flash_sim_time + ((FLASH_SIM_SUBSECTOR_SIZE == size) ?
+		                                           flash_sim_latencies.erase_subsector :
+		                                           flash_sim_latencies.erase_block);
+		ret = FLASH_CTRL_OK;
+	} else {
+		// Error already logged.
+	}
+	return ret;
+}
+
+static uint32_t flash_sim_erase_suspend(flash_sim_device_t *device) {
+	uint32_t ret = FLASH_CTRL_ERROR;
+	if ((0u == device->erase_size) || device->erase_suspended) {
+		FLASH_SIM_ERROR("%s: no erase in progress\n", __func__);
+		flash_sim_counters.nb_errors++;
+	} else {
+		flash_sim_time += flash_sim_latencies.status_poll;
+		device->erase_remaining_time = (device->erase_end_time > flash_sim_time) ?
+		                               (device->erase_end_time - flash_sim_time) : 0u;
+		device->erase_suspended = true;
+		flash_sim_counters.nb_erase_suspend++;
+		ret = FLASH_CTRL_OK;
+	}
+	return ret;
+}
+
+static uint32_t flash_sim_erase_resume(flash_sim_device_t *device) {
+	uint32_t ret = FLASH_CTRL_ERROR;
+	if ((0u == device->erase_size) || !device->erase_suspended) {
+		FLASH_SIM_ERROR("%s: no erase suspended\n", __func__);
+		flash_sim_counters.nb_errors++;
+	} else if (device->mmap_enabled) {
+		FLASH_SIM_ERROR("%s: memory mapped mode enabled\n", __func__);
+		flash_sim_counters.nb_errors++;
+	} else {
+		device->erase_end_time = flash_sim_time + device->erase_remaining_time;
+		device->erase_suspended = false;
+		ret = FLASH_CTRL_OK;
+	}
+	return ret;
+}
+
+static uint32_t flash_sim_write_range(flash_sim_device_t *device, uint8_t *pData, uint32_t addr, uint32_t size) {
+	uint32_t ret = FLASH_CTRL_OK;
+	if ((0u != (addr % FLASH_SIM_PAGE_SIZE)) || !flash_sim_check_access(device, __func__, addr, size)) {
+		ret = FLASH_CTRL_ERROR;
+	}
+	for (uint32_t offset = 0u; (FLASH_CTRL_OK == ret) && (offset < size); offset += FLASH_SIM_PAGE_SIZE) {
+		uint32_t page_size = ((size - offset) < FLASH_SIM_PAGE_SIZE) ? (size - offset) : FLASH_SIM_PAGE_SIZE;
+		ret = flash_sim_page_write(device, pData + offset, addr + offset, page_size);
+	}
+	return ret;
+}
+
+static uint32_t flash_sim_crc(const flash_sim_device_t *device, uint32_t addr, uint32_t size, uint32_t *crc) {
+	uint32_t ret = FLASH_CTRL_ERROR;
+	if (!device->mmap_enabled) {
+		FLASH_SIM_ERROR("%s: memory mapped mode disabled\n", __func__);
+		flash_sim_counters.nb_errors++;
+	} else {
+		const uint8_t *data = &device->memory[addr - flash_sim_start_address(device)];
+		uint32_t value = 0xFFFFFFFFu;
+		for (uint32_t i = 0; i < size; i++) {
+			value ^= data[i];
+			for (uint32_t bit = 0; bit < 8u; bit++) {
+				value = (value >> 1u) ^ (0xEDB88320u & (0u - (value & 1u)));
+			}
+		}
+		*crc = ~value;
+		flash_sim_counters.nb_crc++;
+		flash_sim_time += (flash_sim_latencies.crc_kb * ((size + 1023u) / 1024u));
+		ret = FLASH_CTRL_OK;
+	}
+	return ret;
+}
+
+#if (2u == FLASH_SIM_NB_DEVICES)
+// Flash controller functions of the second device.
+
+static uint32_t flash_sim_device1_page_write(uint8_t *pData, uint32_t addr, uint32_t size) {
+	return flash_sim_page_write(&flash_sim_devices[1], pData, addr, size);
+}
+
+static uint32_t flash_sim_device1_erase_subsector(uint32_t addr) {
+	return flash_sim_erase_subsector(&flash_sim_devices[1], addr);
+}
+
+static uint32_t flash_sim_device1_enable_memory_mapped_mode(void) {
+	return flash_sim_enable_memory_mapped_mode(&flash_sim_devices[1]);
+}
+
+static uint32_t flash_sim_device1_disable_memory_mapped_mode(void) {
+	return flash_sim_disable_memory_mapped_mode(&flash_sim_devices[1]);
+}
+
+static uint32_t flash_sim_device1_blank_check(uint32_t addr, uint32_t size) {
+	return flash_sim_blank_check(&flash_sim_devices[1], addr, size);
+}
+
+static uint32_t flash_sim_device1_erase_block(uint32_t addr) {
+	return flash_sim_erase_block(&flash_sim_devices[1], addr);
+}
+
+static uint32_t flash_sim_device1_page_write_async(uint8_t *pData, uint32_t addr, uint32_t size) {
+	return flash_sim_page_write_async(&flash_sim_devices[1], pData, addr, size);
+}
+
+static uint32_t flash_sim_device1_get_operation_status(void) {
+	return flash_sim_get_operation_status(&flash_sim_devices[1]);
+}
+
+static uint32_t flash_sim_device1_write_range(uint8_t *pData, uint32_t addr, uint32_t size) {
+	return flash_sim_write_range(&flash_sim_devices[1], pData, addr, size);
+}
+
+static uint32_t flash_sim_device1_crc(uint32_t addr, uint32_t size, uint32_t *crc) {
+	return flash_sim_crc(&flash_sim_devices[1], addr, size, crc);
+}
+
+static uint32_t flash_sim_device1_erase_async(uint32_t addr, uint32_t size) {
+	return flash_sim_erase_async(&flash_sim_devices[1], addr, size);
+}
+
+static uint32_t flash_sim_device1_erase_suspend(void) {
+	return flash_sim_erase_suspend(&flash_sim_devices[1]);
+}
+
+static uint32_t flash_sim_device1_erase_resume(void) {
+	return flash_sim_erase_resume(&flash_sim_devices[1]);
+}
+#endif // FLASH_SIM_NB_DEVICES
+
+// -----------------------------------------------------------------------------
+// Public functions
+// -----------------------------------------------------------------------------
+
+void flash_sim_init(const flash_sim_latencies_t *latencies) {
+	flash_sim_latencies = (NULL != latencies) ? *latencies : flash_sim_default_latencies;
+	for (uint32_t i = 0; i < FLASH_SIM_NB_DEVICES; i++) {
+		flash_sim_device_t *device = &flash_sim_devices[i];
+		(void)memset(device->memory, (int)FLASH_SIM_ERASED_BYTE, FLASH_SIM_KF_SIZE);
+		(void)memset(device->erase_counts, 0, sizeof(device->erase_counts));
+		device->mmap_enabled = true;
+		device->async_data = NULL;
+		device->erase_size = 0u;
+	}
+#if (2u == FLASH_SIM_NB_DEVICES)
+	// The small features are placed on the first device, the other ones on the second device.
+	const flash_ctrl_device_t device0 = {
+		.page_write = flash_ctrl_page_write,
+		.erase_subsector = flash_ctrl_erase_subsector,
+		.enable_memory_mapped_mode = flash_ctrl_enable_memory_mapped_mode,
+		.disable_memory_mapped_mode = flash_ctrl_disable_memory_mapped_mode,
+		.get_subsector_address = flash_ctrl_get_subsector_address,
+		.get_page_address = flash_ctrl_get_page_address,
+		.blank_check = flash_ctrl_blank_check,
+		.erase_block = flash_ctrl_erase_block,
+		.page_write_async = flash_ctrl_page_write_async,
+		.get_operation_status = flash_ctrl_get_operation_status,
+		.write_range = flash_ctrl_write_range,
+		.crc = flash_ctrl_crc,
+		.erase_async = flash_ctrl_erase_async,
+		.erase_suspend = flash_ctrl_erase_suspend,
+		.erase_resume = flash_ctrl_erase_resume,
+		.subsector_size = FLASH_SIM_SUBSECTOR_SIZE,
+		.page_size = FLASH_SIM_PAGE_SIZE,
+		.block_size = FLASH_SIM_BLOCK_SIZE,
+		.kf_start_address = flash_sim_start_address(&flash_sim_devices[0]),
+		.kf_end_address = flash_sim_start_address(&flash_sim_devices[0]) + FLASH_SIM_KF_SIZE,
+		.max_feature_size = FLASH_SIM_DEVICE0_MAX_FEATURE_SIZE,
+	};
+	const flash_ctrl_device_t device1 = {
+		.page_write = flash_sim_device1_page_write,
+		.erase_subsector = flash_sim_device1_erase_subsector,
+		.enable_memory_mapped_mode = flash_sim_device1_enable_memory_mapped_mode,
+		.disable_memory_mapped_mode = flash_sim_device1_disable_memory_mapped_mode,
+		.get_subsector_address = flash_ctrl_get_subsector_address,
+		.get_page_address = flash_ctrl_get_page_address,
+		.blank_check = flash_sim_device1_blank_check,
+		.erase_block = flash_sim_device1_erase_block,
+		.page_write_async = flash_sim_device1_page_write_async,
+		.get_operation_status = flash_sim_device1_get_operation_status,
+		.write_range = flash_sim_device1_write_range,
+		.crc = flash_sim_device1_crc,
+		.erase_async = flash_sim_device1_erase_async,
+		.erase_suspend = flash_sim_device1_erase_suspend,
+		.erase_resume = flash_sim_device1_erase_resume,
+		.subsector_size = FLASH_SIM_SUBSECTOR_SIZE,
+		.page_size = FLASH_SIM_PAGE_SIZE,
+		.block_size = FLASH_SIM_BLOCK_SIZE,
+		.kf_start_address = flash_sim_start_address(&flash_sim_devices[1]),
+		.kf_end_address = flash_sim_start_address(&flash_sim_devices[1]) + FLASH_SIM_KF_SIZE,
+		.max_feature_size = 0u,
+	};
+	flash_sim_ctrl_devices[0] = device0;
+	flash_sim_ctrl_devices[1] = device1;
+#endif // FLASH_SIM_NB_DEVICES
+	flash_sim_reset_counters();
+}
+
+void flash_sim_reset_counters(void) {
+	(void)memset(&flash_sim_counters, 0, sizeof(flash_sim_counters));
+	flash_sim_time = 0u;
+	for (uint32_t i = 0; i < FLASH_SIM_NB_DEVICES; i++) {
+		flash_sim_devices[i].async_end_time = 0u;
+		flash_sim_devices[i].erase_end_time = 0u;
+		flash_sim_devices[i].mmap_disable_time = 0u;
+	}
+}
+
+uint32_t flash_sim_get_time(void) {
+	return flash_sim_time;
+}
+
+void flash_sim_get_counters(flash_sim_counters_t *counters) {
+	*counters = flash_sim_counters;
+}
+
+uint32_t flash_sim_get_max_erase_count(void) {
+	uint32_t max = 0u;
+	for (uint32_t i = 0; i < FLASH_SIM_NB_DEVICES; i++) {
+		for (uint32_t j = 0; j < FLASH_SIM_NB_SUBSECTORS; j++) {
+			if (max < flash_sim_devices[i].erase_counts[j]) {
+				max = flash_sim_devices[i].erase_counts[j];
+			}
+		}
+	}
+	return max;
+}
+
+// -----------------------------------------------------------------------------
+// Flash controller functions
+// -----------------------------------------------------------------------------
+
+uint32_t flash_ctrl_startup(void) {
+	return FLASH_CTRL_OK;
+}
+
+uint32_t flash_ctrl_page_write(uint8_t *pData, uint32_t addr, uint32_t size) {
+	return flash_sim_page_write(&flash_sim_devices[0], pData, addr, size);
+}
+
+uint32_t flash_ctrl_erase_subsector(uint32_t addr) {
+	return flash_sim_erase_subsector(&flash_sim_devices[0], addr);
+}
+
+uint32_t flash_ctrl_enable_memory_mapped_mode(void) {
+	return flash_sim_enable_memory_mapped_mode(&flash_sim_devices[0]);
+}
+
+uint32_t flash_ctrl_disable_memory_mapped_mode(void) {
+	return flash_sim_disable_memory_mapped_mode(&flash_sim_devices[0]);
+}
+
+uint32_t flash_ctrl_get_subsector_address(uint32_t address) {
+	return address & ~(FLASH_SIM_SUBSECTOR_SIZE - 1u);
+}
+
+uint32_t flash_ctrl_get_page_address(uint32_t address) {
+	return address & ~(FLASH_SIM_PAGE_SIZE - 1u);
+}
+
+uint32_t flash_ctrl_get_subsector_size(void) {
+	return FLASH_SIM_SUBSECTOR_SIZE;
+}
+
+uint32_t flash_ctrl_get_page_size(void) {
+	return FLASH_SIM_PAGE_SIZE;
+}
+
+uint32_t flash_ctrl_get_kf_start_address(void) {
+	return flash_sim_start_address(&flash_sim_devices[0]);
+}
+
+uint32_t flash_ctrl_get_kf_end_address(void) {
+	return flash_sim_start_address(&flash_sim_devices[0]) + FLASH_SIM_KF_SIZE;
+}
+
+// -----------------------------------------------------------------------------
+// Optional flash controller functions
+// -----------------------------------------------------------------------------
+
+#if (2u == FLASH_SIM_NB_DEVICES)
+const flash_ctrl_device_t *flash_ctrl_get_devices(void) {
+	return flash_sim_ctrl_devices;
+}
+#endif // FLASH_SIM_NB_DEVICES
+
+uint32_t flash_ctrl_blank_check(uint32_t addr, uint32_t size) {
+	return flash_sim_blank_check(&flash_sim_devices[0], addr, size);
+}
+
+uint32_t flash_ctrl_get_block_size(void) {
+	return FLASH_SIM_BLOCK_SIZE;
+}
+
+uint32_t flash_ctrl_erase_block(uint32_t addr) {
+	return flash_sim_erase_block(&flash_sim_devices[0], addr);
+}
+
+uint32_t flash_ctrl_page_write_async(uint8_t *pData, uint32_t addr, uint32_t size) {
+	return flash_sim_page_write_async(&flash_sim_devices[0], pData, addr, size);
+}
+
+uint32_t flash_ctrl_get_operation_status(void) {
+	return flash_sim_get_operation_status(&flash_sim_devices[0]);
+}
+
+uint32_t flash_ctrl_erase_async(uint32_t addr, uint32_t size) {
+	return flash_sim_erase_async(&flash_sim_devices[0], addr, size);
+}
+
+uint32_t flash_ctrl_erase_suspend(void) {
+	return flash_sim_erase_suspend(&flash_sim_devices[0]);
+}
+
+uint32_t flash_ctrl_erase_resume(void) {
+	return flash_sim_erase_resume(&flash_sim_devices[0]);
+}
+
+uint32_t flash_ctrl_write_range(uint8_t *pData, uint32_t addr, uint32_t size) {
+	return flash_sim_write_range(&flash_sim_devices[0], pData, addr, size);
+}
+
+uint32_t flash_ctrl_crc(uint32_t addr, uint32_t size, uint32_t *crc) {
+	return flash_sim_crc(&flash_sim_devices[0], addr, size, crc);
+}